@@ -0,0 +1,440 @@
+//
+//  Board.cpp
+//  Minesweeper1
+//
+
+#include <algorithm>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "Board.h"
+
+void resetBitPlane(BitPlane &plane, int nBits)
+{
+    plane.assign(getBitPlaneWordCount(nBits), 0);
+}
+
+int countBits(const BitPlane &plane)
+{
+    int count = 0;
+
+    for (int wordIndex = 0;
+         wordIndex < plane.size();
+         wordIndex++)
+    {
+        count += __builtin_popcountll(plane[wordIndex]);
+    }
+
+    return count;
+}
+
+void initBoard(Board &board, int width, int height)
+{
+    board.width = width;
+    board.height = height;
+    board.nCells = width * height;
+
+    resetBitPlane(board.mines, board.nCells);
+    resetBitPlane(board.open, board.nCells);
+    resetBitPlane(board.flags, board.nCells);
+    board.adjacentMines.assign(board.nCells, 0);
+}
+
+void placeMines(Board &board, int nMines, Random &random)
+{
+    if (nMines > board.nCells)
+    {
+        nMines = board.nCells;
+    }
+
+    // Floyd's algorithm picks nMines distinct values out of [0, nCells):
+    // for each j in the last nMines slots, pick t in [0, j] and take j
+    // instead if t is already taken.
+    for (int j = board.nCells - nMines; j < board.nCells; j++)
+    {
+        int t = randomInt(random, j + 1);
+
+        if (cellHasMine(board, t))
+        {
+            t = j;
+        }
+
+        setBit(board.mines, t);
+    }
+}
+
+void placeMinesAvoiding(Board &board, int nMines, Random &random, int safeCellIndex)
+{
+    int safeX = getCellX(board, safeCellIndex);
+    int safeY = getCellY(board, safeCellIndex);
+    int excluded[9];
+    int nExcluded = 0;
+
+    // Row-major order, so the list comes out sorted.
+    for (int y = std::max(safeY - 1, 0); y <= std::min(safeY + 1, board.height - 1); y++)
+    {
+        for (int x = std::max(safeX - 1, 0); x <= std::min(safeX + 1, board.width - 1); x++)
+        {
+            excluded[nExcluded++] = getCellIndex(board, x, y);
+        }
+    }
+
+    int nAllowed = board.nCells - nExcluded;
+
+    if (nMines > nAllowed)
+    {
+        nMines = nAllowed;
+    }
+
+    // Floyd's algorithm over [0, nAllowed), with each sample shifted past
+    // the excluded cells so it lands on an allowed one.
+    for (int j = nAllowed - nMines; j < nAllowed; j++)
+    {
+        int t = randomInt(random, j + 1);
+        int cellIndex = t;
+        int jCellIndex = j;
+
+        for (int excludedIndex = 0; excludedIndex < nExcluded; excludedIndex++)
+        {
+            cellIndex += cellIndex >= excluded[excludedIndex] ? 1 : 0;
+            jCellIndex += jCellIndex >= excluded[excludedIndex] ? 1 : 0;
+        }
+
+        if (cellHasMine(board, cellIndex))
+        {
+            cellIndex = jCellIndex;
+        }
+
+        setBit(board.mines, cellIndex);
+    }
+}
+
+static void addToAdjacentCounts(Board &board, int cellIndex, int amount)
+{
+    int cellX = getCellX(board, cellIndex);
+    int cellY = getCellY(board, cellIndex);
+
+    for (int y = std::max(cellY - 1, 0); y <= std::min(cellY + 1, board.height - 1); y++)
+    {
+        for (int x = std::max(cellX - 1, 0); x <= std::min(cellX + 1, board.width - 1); x++)
+        {
+            if (x != cellX || y != cellY)
+            {
+                board.adjacentMines[getCellIndex(board, x, y)] += amount;
+            }
+        }
+    }
+}
+
+void addMine(Board &board, int cellIndex)
+{
+    setBit(board.mines, cellIndex);
+    addToAdjacentCounts(board, cellIndex, 1);
+}
+
+void removeMine(Board &board, int cellIndex)
+{
+    clearBit(board.mines, cellIndex);
+    addToAdjacentCounts(board, cellIndex, -1);
+}
+
+// Eight cells at a time: every possible byte maps to eight 0/1 bytes.
+static std::vector<uint64_t> buildExpandTable()
+{
+    std::vector<uint64_t> expandTable(256, 0);
+
+    for (int value = 0; value < 256; value++)
+    {
+        for (int bit = 0; bit < 8; bit++)
+        {
+            if (value & (1 << bit))
+            {
+                expandTable[value] |= (uint64_t)1 << (bit * 8);
+            }
+        }
+    }
+
+    return expandTable;
+}
+
+// Copies row y of a bitplane into dst[1..width] as one byte per cell,
+// leaving dst[0] and dst[width + 1] as zero padding.
+static void expandBitPlaneRow(const BitPlane &plane, int width, int y, uint8_t *dst)
+{
+    // Local statics are initialized once even with several threads around.
+    static const std::vector<uint64_t> expandTable = buildExpandTable();
+
+    int nWords = (int)plane.size();
+    long long rowStart = (long long)y * width;
+
+    dst[0] = 0;
+
+    for (int x = 0; x < width; x += 8)
+    {
+        long long bitIndex = rowStart + x;
+        int wordIndex = (int)(bitIndex / BITPLANE_WORD_BITS);
+        int shift = (int)(bitIndex % BITPLANE_WORD_BITS);
+
+        uint64_t bits = plane[wordIndex] >> shift;
+
+        if (shift > BITPLANE_WORD_BITS - 8 && wordIndex + 1 < nWords)
+        {
+            bits |= plane[wordIndex + 1] << (BITPLANE_WORD_BITS - shift);
+        }
+
+        int count = std::min(8, width - x);
+        bits &= (1u << count) - 1;
+
+        memcpy(dst + 1 + x, &expandTable[bits & 0xFF], 8);
+    }
+
+    // The last memcpy may have spilled past the row, the padding has to be zero.
+    memset(dst + 1 + width, 0, 8);
+}
+
+// out[x] = sum of the 3x3 block around padded column x + 1, minus the centre.
+// top/middle/bottom are padded rows of width + 2 bytes, sums is scratch.
+static void sumAdjacentRowScalar(const uint8_t *top,
+                                 const uint8_t *middle,
+                                 const uint8_t *bottom,
+                                 uint8_t *sums,
+                                 uint8_t *out,
+                                 int width)
+{
+    for (int x = 0; x < width + 2; x++)
+    {
+        sums[x] = top[x] + middle[x] + bottom[x];
+    }
+
+    for (int x = 0; x < width; x++)
+    {
+        out[x] = sums[x] + sums[x + 1] + sums[x + 2] - middle[x + 1];
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Counts never go above 9, so plain byte adds can't overflow.
+static void sumAdjacentRowSSE2(const uint8_t *top,
+                               const uint8_t *middle,
+                               const uint8_t *bottom,
+                               uint8_t *sums,
+                               uint8_t *out,
+                               int width)
+{
+    int x = 0;
+
+    for (; x + 16 <= width + 2; x += 16)
+    {
+        __m128i t = _mm_loadu_si128((const __m128i *)(top + x));
+        __m128i m = _mm_loadu_si128((const __m128i *)(middle + x));
+        __m128i b = _mm_loadu_si128((const __m128i *)(bottom + x));
+        _mm_storeu_si128((__m128i *)(sums + x), _mm_add_epi8(_mm_add_epi8(t, m), b));
+    }
+
+    for (; x < width + 2; x++)
+    {
+        sums[x] = top[x] + middle[x] + bottom[x];
+    }
+
+    x = 0;
+
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i left = _mm_loadu_si128((const __m128i *)(sums + x));
+        __m128i centre = _mm_loadu_si128((const __m128i *)(sums + x + 1));
+        __m128i right = _mm_loadu_si128((const __m128i *)(sums + x + 2));
+        __m128i self = _mm_loadu_si128((const __m128i *)(middle + x + 1));
+        __m128i total = _mm_add_epi8(_mm_add_epi8(left, centre), right);
+        _mm_storeu_si128((__m128i *)(out + x), _mm_sub_epi8(total, self));
+    }
+
+    for (; x < width; x++)
+    {
+        out[x] = sums[x] + sums[x + 1] + sums[x + 2] - middle[x + 1];
+    }
+}
+
+__attribute__((target("avx2")))
+static void sumAdjacentRowAVX2(const uint8_t *top,
+                               const uint8_t *middle,
+                               const uint8_t *bottom,
+                               uint8_t *sums,
+                               uint8_t *out,
+                               int width)
+{
+    int x = 0;
+
+    for (; x + 32 <= width + 2; x += 32)
+    {
+        __m256i t = _mm256_loadu_si256((const __m256i *)(top + x));
+        __m256i m = _mm256_loadu_si256((const __m256i *)(middle + x));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(bottom + x));
+        _mm256_storeu_si256((__m256i *)(sums + x), _mm256_add_epi8(_mm256_add_epi8(t, m), b));
+    }
+
+    for (; x < width + 2; x++)
+    {
+        sums[x] = top[x] + middle[x] + bottom[x];
+    }
+
+    x = 0;
+
+    for (; x + 32 <= width; x += 32)
+    {
+        __m256i left = _mm256_loadu_si256((const __m256i *)(sums + x));
+        __m256i centre = _mm256_loadu_si256((const __m256i *)(sums + x + 1));
+        __m256i right = _mm256_loadu_si256((const __m256i *)(sums + x + 2));
+        __m256i self = _mm256_loadu_si256((const __m256i *)(middle + x + 1));
+        __m256i total = _mm256_add_epi8(_mm256_add_epi8(left, centre), right);
+        _mm256_storeu_si256((__m256i *)(out + x), _mm256_sub_epi8(total, self));
+    }
+
+    for (; x < width; x++)
+    {
+        out[x] = sums[x] + sums[x + 1] + sums[x + 2] - middle[x + 1];
+    }
+}
+
+#endif
+
+typedef void (*SumAdjacentRowFunction)(const uint8_t *, const uint8_t *, const uint8_t *,
+                                       uint8_t *, uint8_t *, int);
+
+static SumAdjacentRowFunction getSumAdjacentRowFunction(AdjacencyKernel kernel)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (kernel == AdjacencyKernel_Best)
+    {
+        kernel = __builtin_cpu_supports("avx2") ? AdjacencyKernel_AVX2 : AdjacencyKernel_SSE2;
+    }
+
+    switch (kernel)
+    {
+        case AdjacencyKernel_AVX2:
+            if (__builtin_cpu_supports("avx2"))
+            {
+                return sumAdjacentRowAVX2;
+            }
+            return sumAdjacentRowSSE2;
+
+        case AdjacencyKernel_SSE2:
+            return sumAdjacentRowSSE2;
+
+        default:
+            break;
+    }
+#endif
+
+    return sumAdjacentRowScalar;
+}
+
+void computeAdjacentMineCounts(Board &board)
+{
+    computeAdjacentMineCounts(board, AdjacencyKernel_Best);
+}
+
+void computeAdjacentMineCounts(Board &board, AdjacencyKernel kernel)
+{
+    SumAdjacentRowFunction sumAdjacentRow = getSumAdjacentRowFunction(kernel);
+
+    // Three padded byte rows slide down the board, so the padded mine map
+    // never has to exist in full.  The slack covers expandBitPlaneRow's
+    // eight-byte writes.
+    int rowLength = board.width + 2 + 8;
+    std::vector<uint8_t> rows(rowLength * 3, 0);
+    std::vector<uint8_t> sums(rowLength, 0);
+
+    uint8_t *top = &rows[0];
+    uint8_t *middle = &rows[rowLength];
+    uint8_t *bottom = &rows[rowLength * 2];
+
+    if (board.height > 0)
+    {
+        expandBitPlaneRow(board.mines, board.width, 0, middle);
+    }
+
+    for (int y = 0; y < board.height; y++)
+    {
+        if (y + 1 < board.height)
+        {
+            expandBitPlaneRow(board.mines, board.width, y + 1, bottom);
+        }
+        else
+        {
+            memset(bottom, 0, rowLength);
+        }
+
+        sumAdjacentRow(top, middle, bottom, &sums[0],
+                       &board.adjacentMines[getCellIndex(board, 0, y)], board.width);
+
+        uint8_t *oldTop = top;
+        top = middle;
+        middle = bottom;
+        bottom = oldTop;
+    }
+}
+
+int floodOpen(Board &board, int rootCellIndex, FloodFill &fill)
+{
+    return floodOpenCells(board, &rootCellIndex, 1, fill);
+}
+
+int floodOpenCells(Board &board, const int *rootCells, int nRoots, FloodFill &fill)
+{
+    std::vector<int> &openedCells = fill.openedCells;
+    openedCells.clear();
+    fill.nClearedFlags = 0;
+
+    for (int rootIndex = 0; rootIndex < nRoots; rootIndex++)
+    {
+        if (!cellIsOpen(board, rootCells[rootIndex]))
+        {
+            fill.nClearedFlags += cellHasFlag(board, rootCells[rootIndex]) ? 1 : 0;
+            setBit(board.open, rootCells[rootIndex]);
+            clearBit(board.flags, rootCells[rootIndex]);
+            openedCells.push_back(rootCells[rootIndex]);
+        }
+    }
+
+    for (int queueHead = 0;
+         queueHead < openedCells.size();
+         queueHead++)
+    {
+        int cellIndex = openedCells[queueHead];
+
+        if (board.adjacentMines[cellIndex] != 0)
+        {
+            continue;
+        }
+
+        int cellX = getCellX(board, cellIndex);
+        int cellY = getCellY(board, cellIndex);
+        int minX = std::max(cellX - 1, 0);
+        int maxX = std::min(cellX + 1, board.width - 1);
+        int minY = std::max(cellY - 1, 0);
+        int maxY = std::min(cellY + 1, board.height - 1);
+
+        // A zero cell has no mine neighbours, so anything closed is safe.
+        for (int y = minY; y <= maxY; y++)
+        {
+            for (int x = minX; x <= maxX; x++)
+            {
+                int neighbourIndex = getCellIndex(board, x, y);
+
+                if (!cellIsOpen(board, neighbourIndex))
+                {
+                    fill.nClearedFlags += cellHasFlag(board, neighbourIndex) ? 1 : 0;
+                    setBit(board.open, neighbourIndex);
+                    clearBit(board.flags, neighbourIndex);
+                    openedCells.push_back(neighbourIndex);
+                }
+            }
+        }
+    }
+
+    return (int)openedCells.size();
+}
@@ -0,0 +1,150 @@
+//
+//  Board.h
+//  Minesweeper1
+//
+
+#ifndef Board_h
+#define Board_h
+
+#include <stdint.h>
+#include <vector>
+
+#include "Random.h"
+
+// One bit per cell, 64 cells per word.
+typedef std::vector<uint64_t> BitPlane;
+
+// The board is stored as a structure of arrays: mine/open/flag state are
+// bitplanes and the adjacency counts are one byte each, which is about
+// 1.4 bytes per cell.  Cells are addressed by their row-major index, the
+// pixel position is derived from it by whoever draws the board.
+typedef struct
+{
+    int width = 0;
+    int height = 0;
+    int nCells = 0;
+    BitPlane mines;
+    BitPlane open;
+    BitPlane flags;
+    std::vector<uint8_t> adjacentMines;
+} Board;
+
+static const int BITPLANE_WORD_BITS = 64;
+
+inline int getBitPlaneWordCount(int nBits)
+{
+    return (nBits + BITPLANE_WORD_BITS - 1) / BITPLANE_WORD_BITS;
+}
+
+inline bool getBit(const BitPlane &plane, int index)
+{
+    return (plane[index / BITPLANE_WORD_BITS] >> (index % BITPLANE_WORD_BITS)) & 1;
+}
+
+inline void setBit(BitPlane &plane, int index)
+{
+    plane[index / BITPLANE_WORD_BITS] |= (uint64_t)1 << (index % BITPLANE_WORD_BITS);
+}
+
+inline void clearBit(BitPlane &plane, int index)
+{
+    plane[index / BITPLANE_WORD_BITS] &= ~((uint64_t)1 << (index % BITPLANE_WORD_BITS));
+}
+
+inline void toggleBit(BitPlane &plane, int index)
+{
+    plane[index / BITPLANE_WORD_BITS] ^= (uint64_t)1 << (index % BITPLANE_WORD_BITS);
+}
+
+// Sizes the plane for nBits and zeroes it without giving memory back.
+void resetBitPlane(BitPlane &plane, int nBits);
+int countBits(const BitPlane &plane);
+
+inline int getCellIndex(const Board &board, int x, int y)
+{
+    return y * board.width + x;
+}
+
+inline int getCellX(const Board &board, int cellIndex)
+{
+    return cellIndex % board.width;
+}
+
+inline int getCellY(const Board &board, int cellIndex)
+{
+    return cellIndex / board.width;
+}
+
+inline bool isInsideBoard(const Board &board, int x, int y)
+{
+    return x >= 0 && x < board.width && y >= 0 && y < board.height;
+}
+
+inline bool cellHasMine(const Board &board, int cellIndex)
+{
+    return getBit(board.mines, cellIndex);
+}
+
+inline bool cellIsOpen(const Board &board, int cellIndex)
+{
+    return getBit(board.open, cellIndex);
+}
+
+inline bool cellHasFlag(const Board &board, int cellIndex)
+{
+    return getBit(board.flags, cellIndex);
+}
+
+inline int getAdjacentMines(const Board &board, int cellIndex)
+{
+    return board.adjacentMines[cellIndex];
+}
+
+// Scratch space for floodOpen.  Keep one around and reuse it, it only
+// grows until it can hold a whole board.
+typedef struct
+{
+    // Doubles as the BFS queue: cells are opened as they are queued, and
+    // everything before queueHead has had its neighbours looked at.
+    std::vector<int> openedCells;
+    // Flags on cells the fill opened (always wrong ones, the cells are safe).
+    int nClearedFlags;
+} FloodFill;
+
+typedef enum
+{
+    AdjacencyKernel_Best,
+    AdjacencyKernel_Scalar,
+    AdjacencyKernel_SSE2,
+    AdjacencyKernel_AVX2
+} AdjacencyKernel;
+
+// Every cell closed, unflagged and mine-free.
+void initBoard(Board &board, int width, int height);
+// Recomputes every adjacency count from the mine bitplane, a row at a
+// time with SIMD byte adds.  The best kernel the CPU supports is picked
+// at runtime, AdjacencyKernel can force one for benchmarking.
+void computeAdjacentMineCounts(Board &board);
+void computeAdjacentMineCounts(Board &board, AdjacencyKernel kernel);
+// Scatters nMines mines over an empty board with Floyd's sampling, using
+// the mine bitplane as the sample set.  That is one random number
+// per mine no matter how dense the board is.  Adjacency counts are left
+// for computeAdjacentMineCounts.
+void placeMines(Board &board, int nMines, Random &random);
+// Same, but the 3x3 block around safeCellIndex stays mine-free, so that
+// cell opens onto a zero.  Capped at what fits outside the block.
+void placeMinesAvoiding(Board &board, int nMines, Random &random, int safeCellIndex);
+// One mine on or off a board whose counts are already computed, patching
+// the counts of the eight cells around it.
+void addMine(Board &board, int cellIndex);
+void removeMine(Board &board, int cellIndex);
+// Opens rootCellIndex and, if it has no adjacent mines, everything reachable
+// through other zero cells.  fill.openedCells ends up holding exactly the
+// cells that were opened; the count is returned.  The caller makes sure
+// the root isn't a mine.
+int floodOpen(Board &board, int rootCellIndex, FloodFill &fill);
+// Same from several roots at once, as one pass: regions the roots share are
+// only walked once.  Roots that are already open are skipped.
+int floodOpenCells(Board &board, const int *rootCells, int nRoots, FloodFill &fill);
+
+#endif /* Board_h */
@@ -0,0 +1,387 @@
+//
+//  BoardPool.cpp
+//  Minesweeper1
+//
+
+#include <algorithm>
+#include <cmath>
+
+#include "BoardPool.h"
+#include "Profile.h"
+
+static bool pushBoard(BoardQueue &queue, PooledBoard *pooled)
+{
+    unsigned tail = queue.tail.load(std::memory_order_relaxed);
+
+    if (tail - queue.head.load(std::memory_order_acquire) == BOARD_QUEUE_CAPACITY)
+    {
+        return false;
+    }
+
+    queue.slots[tail % BOARD_QUEUE_CAPACITY] = pooled;
+    queue.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+static PooledBoard *popBoard(BoardQueue &queue)
+{
+    unsigned head = queue.head.load(std::memory_order_relaxed);
+
+    if (head == queue.tail.load(std::memory_order_acquire))
+    {
+        return nullptr;
+    }
+
+    PooledBoard *pooled = queue.slots[head % BOARD_QUEUE_CAPACITY];
+    queue.head.store(head + 1, std::memory_order_release);
+    return pooled;
+}
+
+static int getQueueSize(const BoardQueue &queue)
+{
+    return (int)(queue.tail.load(std::memory_order_acquire) - queue.head.load(std::memory_order_acquire));
+}
+
+static void initBoardQueue(BoardQueue &queue)
+{
+    queue.head.store(0);
+    queue.tail.store(0);
+}
+
+static void emptyBoardQueue(BoardQueue &queue)
+{
+    PooledBoard *pooled;
+
+    while ((pooled = popBoard(queue)) != nullptr)
+    {
+        delete pooled;
+    }
+}
+
+static bool isSameDifficulty(Difficulty a, Difficulty b)
+{
+    return a.nCols == b.nCols && a.nRows == b.nRows && a.nMines == b.nMines;
+}
+
+static bool isSameOrder(const BoardOrder &a, const BoardOrder &b)
+{
+    return isSameDifficulty(a.difficulty, b.difficulty) &&
+           a.layOutMines == b.layOutMines &&
+           a.useFixedSeed == b.useFixedSeed &&
+           (!a.useFixedSeed || a.fixedSeed == b.fixedSeed);
+}
+
+static bool isMadeToOrder(const PooledBoard &pooled, const BoardOrder &order)
+{
+    return isSameDifficulty(pooled.game.difficulty, order.difficulty) &&
+           pooled.game.minesPlaced == order.layOutMines &&
+           (!order.useFixedSeed || pooled.game.seed == order.fixedSeed);
+}
+
+// Roughly: three board bitplanes, five solver ones, the adjacency counts
+// and the mine list.
+static size_t estimateGameBytes(Difficulty difficulty)
+{
+    return (size_t)difficulty.nCols * difficulty.nRows * 2 + (size_t)difficulty.nMines * sizeof(int);
+}
+
+static size_t getPooledBoardBytes(const PooledBoard &pooled)
+{
+    const Game &game = pooled.game;
+    const Board &board = game.board;
+    const Solver &solver = pooled.solver;
+
+    return (board.mines.capacity() + board.open.capacity() + board.flags.capacity() +
+            solver.knownMines.capacity() + solver.knownSafe.capacity() + solver.isConstraint.capacity() +
+            solver.inWorklist.capacity() + solver.inPairWorklist.capacity()) * sizeof(uint64_t) +
+           board.adjacentMines.capacity() +
+           (game.mineCells.capacity() + game.floodFill.openedCells.capacity() +
+            solver.worklist.capacity() + solver.pairWorklist.capacity() +
+            solver.constraints.capacity() + solver.safeCells.capacity()) * sizeof(int);
+}
+
+static uint64_t pickSeed(const BoardOrder &order)
+{
+    return order.useFixedSeed ? order.fixedSeed : makeRandomSeed();
+}
+
+// Waking takes the mutex so a wake can't slip in between the pool's thread
+// checking for work and going to sleep.
+static void wakeBoardPool(BoardPool &pool)
+{
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+    }
+
+    pool.wakeCondition.notify_one();
+}
+
+// Enough made games to cover the time making them takes, twice over for
+// jitter, going by how often games have been taken.
+static void updateTargetDepth(BoardPool &pool)
+{
+    int depth = BOARD_POOL_MIN_DEPTH;
+    double makeMs = pool.makeMs.load();
+
+    if (pool.restartMs > 0.0)
+    {
+        depth = (int)std::ceil(2.0 * makeMs / pool.restartMs);
+    }
+
+    int maxDepth = (int)std::min<size_t>(BOARD_POOL_MAX_DEPTH,
+                                         std::max<size_t>(BOARD_POOL_BYTES / estimateGameBytes(pool.order.difficulty), 1));
+
+    pool.targetDepth.store(std::max(BOARD_POOL_MIN_DEPTH, std::min(depth, maxDepth)));
+}
+
+// The rest of the pool's thread's functions only run on that thread.
+
+// Newest first within BOARD_POOL_SPARE_BYTES.
+static void keepSpareBoard(BoardPool &pool, std::unique_ptr<PooledBoard> pooled)
+{
+    pool.spareBoards.push_back(std::move(pooled));
+
+    size_t spareBytes = 0;
+    int firstKept = (int)pool.spareBoards.size();
+
+    while (firstKept > 0)
+    {
+        spareBytes += getPooledBoardBytes(*pool.spareBoards[firstKept - 1]);
+
+        if (spareBytes > BOARD_POOL_SPARE_BYTES)
+        {
+            break;
+        }
+
+        firstKept--;
+    }
+
+    pool.spareBoards.erase(pool.spareBoards.begin(), pool.spareBoards.begin() + firstKept);
+}
+
+// A spare of the same size keeps its memory as it is, any other spare at
+// least saves some of the allocating.
+static std::unique_ptr<PooledBoard> takeSpareBoard(BoardPool &pool, Difficulty difficulty)
+{
+    if (pool.spareBoards.empty())
+    {
+        return std::unique_ptr<PooledBoard>(new PooledBoard());
+    }
+
+    int spareIndex = (int)pool.spareBoards.size() - 1;
+
+    for (int candidateIndex = spareIndex; candidateIndex >= 0; candidateIndex--)
+    {
+        const Board &board = pool.spareBoards[candidateIndex]->game.board;
+
+        if (board.width == difficulty.nCols && board.height == difficulty.nRows)
+        {
+            spareIndex = candidateIndex;
+            break;
+        }
+    }
+
+    std::unique_ptr<PooledBoard> pooled = std::move(pool.spareBoards[spareIndex]);
+    pool.spareBoards.erase(pool.spareBoards.begin() + spareIndex);
+    return pooled;
+}
+
+static void makeGame(PooledBoard &pooled, const BoardOrder &order)
+{
+    PROFILE_SCOPE("makeGame");
+    uint64_t seed = pickSeed(order);
+
+    if (order.layOutMines)
+    {
+        newGameWithMines(pooled.game, order.difficulty, seed);
+    }
+    else
+    {
+        newGame(pooled.game, order.difficulty, seed);
+    }
+
+    initSolver(pooled.solver, pooled.game.board);
+}
+
+static bool needsMadeBoard(const BoardPool &pool)
+{
+    return pool.hasOrder && getQueueSize(pool.madeBoards) < pool.targetDepth.load();
+}
+
+static void runBoardPool(BoardPool *pool)
+{
+    nameProfileThread("board pool");
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    unsigned lastMadeVersion = 0;
+
+    while (true)
+    {
+        pool->wakeCondition.wait(lock, [pool]() {
+            return pool->stopping || getQueueSize(pool->usedBoards) > 0 || needsMadeBoard(*pool);
+        });
+
+        if (pool->stopping)
+        {
+            return;
+        }
+
+        BoardOrder order = pool->order;
+        unsigned orderVersion = pool->orderVersion;
+        PooledBoard *used = popBoard(pool->usedBoards);
+
+        lock.unlock();
+
+        if (used != nullptr)
+        {
+            // Cleared when it's next made into a game.
+            keepSpareBoard(*pool, std::unique_ptr<PooledBoard>(used));
+            lock.lock();
+            continue;
+        }
+
+        std::unique_ptr<PooledBoard> pooled = takeSpareBoard(*pool, order.difficulty);
+        auto start = std::chrono::steady_clock::now();
+        makeGame(*pooled, order);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        // A new order starts its own average.
+        double makeMs = pool->makeMs.load();
+        pool->makeMs.store(orderVersion == lastMadeVersion ? makeMs * 0.75 + elapsed.count() * 0.25 :
+                                                             elapsed.count());
+        lastMadeVersion = orderVersion;
+
+        lock.lock();
+
+        // Pushed under the mutex so stockBoardPool can't change the order
+        // between the check and the push.
+        if (pool->orderVersion == orderVersion && pushBoard(pool->madeBoards, pooled.get()))
+        {
+            pooled.release();
+            continue;
+        }
+
+        lock.unlock();
+        keepSpareBoard(*pool, std::move(pooled));
+        lock.lock();
+    }
+}
+
+void startBoardPool(BoardPool &pool)
+{
+    initBoardQueue(pool.madeBoards);
+    initBoardQueue(pool.usedBoards);
+    pool.orderVersion = 0;
+    pool.hasOrder = false;
+    pool.stopping = false;
+    pool.targetDepth.store(BOARD_POOL_MIN_DEPTH);
+    pool.makeMs.store(0.0);
+    pool.restartMs = 0.0;
+    pool.hasTaken = false;
+    pool.thread = std::thread(runBoardPool, &pool);
+}
+
+void stopBoardPool(BoardPool &pool)
+{
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.stopping = true;
+    }
+
+    pool.wakeCondition.notify_all();
+
+    if (pool.thread.joinable())
+    {
+        pool.thread.join();
+    }
+
+    emptyBoardQueue(pool.madeBoards);
+    emptyBoardQueue(pool.usedBoards);
+    pool.spareBoards.clear();
+}
+
+// Everything from here on runs on the thread starting games.
+
+static void giveBackBoard(BoardPool &pool, PooledBoard *pooled)
+{
+    // The very first game has nothing worth keeping, and a full queue
+    // means the pool's thread is far behind anyway.
+    if (pooled->game.board.nCells == 0 || !pushBoard(pool.usedBoards, pooled))
+    {
+        delete pooled;
+    }
+}
+
+void stockBoardPool(BoardPool &pool, BoardOrder order)
+{
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+
+        if (pool.hasOrder && isSameOrder(pool.order, order))
+        {
+            return;
+        }
+
+        pool.order = order;
+        pool.orderVersion++;
+        pool.hasOrder = true;
+
+        // Drained under the mutex too, so every game left in the queue was
+        // made to the old order and the pool's thread can't push one made
+        // to the new order in the meantime.
+        PooledBoard *pooled;
+
+        while ((pooled = popBoard(pool.madeBoards)) != nullptr)
+        {
+            giveBackBoard(pool, pooled);
+        }
+
+        updateTargetDepth(pool);
+    }
+
+    pool.wakeCondition.notify_one();
+}
+
+bool takeBoard(BoardPool &pool, Game &game, Solver &solver)
+{
+    auto now = std::chrono::steady_clock::now();
+
+    if (pool.hasTaken)
+    {
+        std::chrono::duration<double, std::milli> sinceLastTake = now - pool.lastTake;
+        pool.restartMs = pool.restartMs > 0.0 ? pool.restartMs * 0.75 + sinceLastTake.count() * 0.25 :
+                                                sinceLastTake.count();
+    }
+
+    pool.lastTake = now;
+    pool.hasTaken = true;
+    updateTargetDepth(pool);
+
+    PooledBoard *pooled = popBoard(pool.madeBoards);
+
+    // stockBoardPool already drained any made to an old order.  Checked
+    // anyway, a game of the wrong size would be far worse than a clear.
+    while (pooled != nullptr && !isMadeToOrder(*pooled, pool.order))
+    {
+        giveBackBoard(pool, pooled);
+        pooled = popBoard(pool.madeBoards);
+    }
+
+    if (pooled == nullptr)
+    {
+        newGame(game, pool.order.difficulty, pickSeed(pool.order));
+        initSolver(solver, game.board);
+        wakeBoardPool(pool);
+        return false;
+    }
+
+    std::swap(game, pooled->game);
+    std::swap(solver, pooled->solver);
+    giveBackBoard(pool, pooled);
+    wakeBoardPool(pool);
+    return true;
+}
+
+int getBoardPoolDepth(const BoardPool &pool)
+{
+    return getQueueSize(pool.madeBoards);
+}
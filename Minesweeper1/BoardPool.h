@@ -0,0 +1,115 @@
+//
+//  BoardPool.h
+//  Minesweeper1
+//
+
+#ifndef BoardPool_h
+#define BoardPool_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Game.h"
+#include "Solver.h"
+
+// Games made ahead of time on the pool's own thread, for the board the
+// player is about to get.  Starting a game swaps a finished one in instead
+// of clearing about 2 bytes a cell (board and solver) and laying the mines
+// out on the spot.  The game it replaces goes back to the pool, whose
+// thread reuses its memory for the next one, so storage is only allocated
+// the first time a size is dealt.
+//
+// Made games come over in one single-producer/single-consumer ring and
+// used ones go back in another: the pool's thread is the only one to push
+// made games and pop used ones, the thread starting games the only one to
+// do the opposite.  Neither ever waits on the other; the mutex is only
+// for the order and for the pool's thread to sleep on.
+//
+// How many games are kept made follows how fast the player restarts: one
+// more than how many a restart interval's worth of making takes, within
+// BOARD_POOL_MAX_DEPTH and BOARD_POOL_BYTES.
+
+static const int BOARD_POOL_MIN_DEPTH = 1;
+static const int BOARD_POOL_MAX_DEPTH = 4;
+// What made games may take up between them.  There is always room for one.
+static const size_t BOARD_POOL_BYTES = 96 << 20;
+// Used games of other sizes are kept within this, so going back to a
+// difficulty doesn't allocate either.  Oldest go first.
+static const size_t BOARD_POOL_SPARE_BYTES = 64 << 20;
+// Power of two, and more than BOARD_POOL_MAX_DEPTH so an order change can
+// hand every made game back at once.
+static const unsigned BOARD_QUEUE_CAPACITY = 8;
+
+typedef struct
+{
+    Game game;
+    // Initialized on the new game's board.
+    Solver solver;
+} PooledBoard;
+
+// Owns the games between a push and the pop that takes them out.
+typedef struct
+{
+    PooledBoard *slots[BOARD_QUEUE_CAPACITY];
+    // Only the consumer moves head, only the producer moves tail.
+    std::atomic<unsigned> head;
+    std::atomic<unsigned> tail;
+} BoardQueue;
+
+// What games to make.
+typedef struct
+{
+    Difficulty difficulty;
+    // Otherwise the board is only cleared and the mines go down on the
+    // first reveal, e.g. for no-guess boards.
+    bool layOutMines;
+    bool useFixedSeed;
+    uint64_t fixedSeed;
+} BoardOrder;
+
+typedef struct
+{
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    BoardQueue madeBoards;
+    BoardQueue usedBoards;
+    // Written by the starting thread under the mutex; orderVersion goes up
+    // with every change so the pool's thread can tell a game made to an
+    // old order.
+    BoardOrder order;
+    unsigned orderVersion;
+    bool hasOrder;
+    bool stopping;
+    std::atomic<int> targetDepth;
+    // Moving averages: how long making one game takes, and the time
+    // between games being taken.
+    std::atomic<double> makeMs;
+    double restartMs;
+    std::chrono::steady_clock::time_point lastTake;
+    bool hasTaken;
+    // Only touched by the pool's thread.
+    std::vector<std::unique_ptr<PooledBoard>> spareBoards;
+} BoardPool;
+
+void startBoardPool(BoardPool &pool);
+void stopBoardPool(BoardPool &pool);
+// Games are made to this order from now on.  If it changed, games already
+// made to the old one go back to the pool.
+void stockBoardPool(BoardPool &pool, BoardOrder order);
+// Starts game and solver on a game made to the current order: a made one
+// is swapped in and the old game goes back to the pool.  With none made
+// the board is cleared in place and the mines wait for the first reveal
+// whatever the order says, so starting never costs more than a clear.
+// Returns whether a made game was used.
+bool takeBoard(BoardPool &pool, Game &game, Solver &solver);
+int getBoardPoolDepth(const BoardPool &pool);
+
+#endif /* BoardPool_h */
@@ -0,0 +1,456 @@
+//
+//  Game.cpp
+//  Minesweeper1
+//
+
+#include <algorithm>
+#include <stdlib.h>
+
+#include "Game.h"
+#include "Profile.h"
+
+// Walks the mine bitplane for the mine list, the first time it's needed.
+static void listMines(Game &game)
+{
+    if (game.mineCellsListed)
+    {
+        return;
+    }
+
+    const Board &board = game.board;
+    // Sized up front, so filling it in is plain stores.
+    game.mineCells.resize(game.nMines);
+    int *mineCell = game.mineCells.data();
+
+    for (int wordIndex = 0;
+         wordIndex < board.mines.size();
+         wordIndex++)
+    {
+        uint64_t mines = board.mines[wordIndex];
+
+        while (mines != 0)
+        {
+            *mineCell++ = wordIndex * BITPLANE_WORD_BITS + __builtin_ctzll(mines);
+            mines &= mines - 1;
+        }
+    }
+
+    game.mineCellsListed = true;
+}
+
+static int countCorrectFlags(const Board &board)
+{
+    int nCorrectFlags = 0;
+
+    for (int wordIndex = 0;
+         wordIndex < board.mines.size();
+         wordIndex++)
+    {
+        nCorrectFlags += __builtin_popcountll(board.mines[wordIndex] & board.flags[wordIndex]);
+    }
+
+    return nCorrectFlags;
+}
+
+// Once the mine bitplane is final.  The list waits for listMines.
+static void setMinesPlaced(Game &game)
+{
+    const Board &board = game.board;
+    game.nMines = 0;
+    game.nCorrectFlags = 0;
+
+    // placeMinesAvoiding caps the count at what fits.  Flags can already
+    // be down, so they're counted in the same pass.
+    for (int wordIndex = 0;
+         wordIndex < board.mines.size();
+         wordIndex++)
+    {
+        uint64_t mines = board.mines[wordIndex];
+        game.nMines += __builtin_popcountll(mines);
+        game.nCorrectFlags += __builtin_popcountll(mines & board.flags[wordIndex]);
+    }
+
+    game.correctFlagsCounted = true;
+    game.minesPlaced = true;
+    game.mineCells.clear();
+    game.mineCellsListed = false;
+}
+
+static bool isInBlock(const Board &board, int cellIndex, int blockX, int blockY)
+{
+    return std::abs(getCellX(board, cellIndex) - blockX) <= 1 &&
+           std::abs(getCellY(board, cellIndex) - blockY) <= 1;
+}
+
+// A mine-free cell outside the block, or -1 if there are none.
+static int findFreeCellOutsideBlock(const Board &board, Random &random, int blockX, int blockY)
+{
+    for (int attempt = 0; attempt < 32; attempt++)
+    {
+        int cellIndex = randomInt(random, board.nCells);
+
+        if (!cellHasMine(board, cellIndex) && !isInBlock(board, cellIndex, blockX, blockY))
+        {
+            return cellIndex;
+        }
+    }
+
+    // Hardly anything is free, walk the board from a random cell instead.
+    int start = randomInt(random, board.nCells);
+
+    for (int offset = 0; offset < board.nCells; offset++)
+    {
+        int cellIndex = (start + offset) % board.nCells;
+
+        if (!cellHasMine(board, cellIndex) && !isInBlock(board, cellIndex, blockX, blockY))
+        {
+            return cellIndex;
+        }
+    }
+
+    return -1;
+}
+
+// For boards laid out up front: the mines in the 3x3 block around the first
+// reveal go to random free cells, or off the board when it's too full.
+static void clearStartBlock(Game &game, int startCellIndex)
+{
+    Board &board = game.board;
+    int startX = getCellX(board, startCellIndex);
+    int startY = getCellY(board, startCellIndex);
+    int blockMines[9];
+    int nBlockMines = 0;
+
+    game.clearStartBlockOnReveal = false;
+
+    for (int y = std::max(startY - 1, 0); y <= std::min(startY + 1, board.height - 1); y++)
+    {
+        for (int x = std::max(startX - 1, 0); x <= std::min(startX + 1, board.width - 1); x++)
+        {
+            int cellIndex = getCellIndex(board, x, y);
+
+            if (cellHasMine(board, cellIndex))
+            {
+                blockMines[nBlockMines++] = cellIndex;
+            }
+        }
+    }
+
+    // A list made up front comes out of listMines sorted, so find every
+    // slot before any of them change.
+    int mineSlots[9];
+
+    for (int blockIndex = 0; game.mineCellsListed && blockIndex < nBlockMines; blockIndex++)
+    {
+        mineSlots[blockIndex] = (int)(std::lower_bound(game.mineCells.begin(), game.mineCells.end(),
+                                                       blockMines[blockIndex]) - game.mineCells.begin());
+    }
+
+    Random random;
+    seedRandom(random, game.seed ^ 0xc2b2ae3d27d4eb4fULL);
+    int nDropped = 0;
+
+    for (int blockIndex = 0; blockIndex < nBlockMines; blockIndex++)
+    {
+        int fromCellIndex = blockMines[blockIndex];
+        int toCellIndex = findFreeCellOutsideBlock(board, random, startX, startY);
+
+        removeMine(board, fromCellIndex);
+        game.nCorrectFlags -= cellHasFlag(board, fromCellIndex) ? 1 : 0;
+
+        if (game.mineCellsListed)
+        {
+            game.mineCells[mineSlots[blockIndex]] = toCellIndex;
+        }
+
+        if (toCellIndex < 0)
+        {
+            nDropped++;
+            continue;
+        }
+
+        addMine(board, toCellIndex);
+        game.nCorrectFlags += cellHasFlag(board, toCellIndex) ? 1 : 0;
+    }
+
+    game.nMines -= nDropped;
+
+    if (nDropped > 0 && game.mineCellsListed)
+    {
+        game.mineCells.erase(std::remove(game.mineCells.begin(), game.mineCells.end(), -1),
+                             game.mineCells.end());
+    }
+}
+
+static void putMinesInNRandomCells(Game &game, int nCells, int safeCellIndex)
+{
+    Random random;
+    seedRandom(random, game.seed);
+    placeMinesAvoiding(game.board, nCells, random, safeCellIndex);
+    computeAdjacentMineCounts(game.board);
+    setMinesPlaced(game);
+}
+
+static void revealMines(Game &game, GameDelta &delta)
+{
+    Board &board = game.board;
+    listMines(game);
+
+    for (int mineIndex = 0;
+         mineIndex < game.mineCells.size();
+         mineIndex++)
+    {
+        int cellIndex = game.mineCells[mineIndex];
+
+        if (!cellIsOpen(board, cellIndex))
+        {
+            setBit(board.open, cellIndex);
+            delta.changedCells.push_back(cellIndex);
+        }
+    }
+}
+
+static void addFlag(Game &game, int cellIndex)
+{
+    game.nFlags++;
+    game.nCorrectFlags += game.minesPlaced && cellHasMine(game.board, cellIndex) ? 1 : 0;
+}
+
+static void removeFlag(Game &game, int cellIndex)
+{
+    game.nFlags--;
+    game.nCorrectFlags -= game.minesPlaced && cellHasMine(game.board, cellIndex) ? 1 : 0;
+}
+
+// Cells a flood fill opens are never mines, so the flags it clears were
+// all wrong ones.
+static void addFloodFillToDelta(Game &game, int nOpened, GameDelta &delta)
+{
+    game.nOpenedCells += nOpened;
+    game.nFlags -= game.floodFill.nClearedFlags;
+
+    delta.changedCells.insert(delta.changedCells.end(),
+                              game.floodFill.openedCells.begin(),
+                              game.floodFill.openedCells.end());
+}
+
+static void loseGame(Game &game, GameDelta &delta)
+{
+    game.status = GameStatus_Lost;
+    revealMines(game, delta);
+}
+
+static void winGame(Game &game, GameDelta &delta)
+{
+    game.status = GameStatus_Won;
+    revealMines(game, delta);
+}
+
+static void uncoverPartOfBoard(Game &game, int rootCellIndex, GameDelta &delta)
+{
+    PROFILE_SCOPE("uncoverPartOfBoard");
+    addFloodFillToDelta(game, floodOpen(game.board, rootCellIndex, game.floodFill), delta);
+}
+
+static void checkForWin(Game &game, GameDelta &delta)
+{
+    if (game.board.nCells - game.nOpenedCells == game.nMines)
+    {
+        winGame(game, delta);
+    }
+}
+
+// One look at the neighbours counts the flags and picks out what to open,
+// then every neighbour goes into a single flood fill.
+static void chordCell(Game &game, int cellIndex, GameDelta &delta)
+{
+    Board &board = game.board;
+    int cellX = getCellX(board, cellIndex);
+    int cellY = getCellY(board, cellIndex);
+    int minX = std::max(cellX - 1, 0);
+    int maxX = std::min(cellX + 1, board.width - 1);
+    int minY = std::max(cellY - 1, 0);
+    int maxY = std::min(cellY + 1, board.height - 1);
+    int rootCells[8];
+    int nRoots = 0;
+    int nFlags = 0;
+    bool hitMine = false;
+
+    for (int y = minY; y <= maxY; y++)
+    {
+        for (int x = minX; x <= maxX; x++)
+        {
+            int neighbourIndex = getCellIndex(board, x, y);
+
+            if (cellHasFlag(board, neighbourIndex))
+            {
+                nFlags++;
+            }
+            else if (!cellIsOpen(board, neighbourIndex))
+            {
+                rootCells[nRoots++] = neighbourIndex;
+                hitMine = hitMine || cellHasMine(board, neighbourIndex);
+            }
+        }
+    }
+
+    if (nFlags != getAdjacentMines(board, cellIndex) || nRoots == 0)
+    {
+        return;
+    }
+
+    if (hitMine)
+    {
+        // A flag was in the wrong place.
+        loseGame(game, delta);
+        return;
+    }
+
+    addFloodFillToDelta(game, floodOpenCells(board, rootCells, nRoots, game.floodFill), delta);
+    checkForWin(game, delta);
+}
+
+int getCorrectFlags(Game &game)
+{
+    if (!game.correctFlagsCounted)
+    {
+        game.nCorrectFlags = countCorrectFlags(game.board);
+        game.correctFlagsCounted = true;
+    }
+
+    return game.nCorrectFlags;
+}
+
+void newGame(Game &game, Difficulty difficulty, uint64_t seed)
+{
+    // Nothing to lay out until the first click, so opening a huge board
+    // costs no more than clearing it.
+    initBoard(game.board, difficulty.nCols, difficulty.nRows);
+    game.difficulty = difficulty;
+    game.seed = seed;
+    game.status = GameStatus_Playing;
+    game.nOpenedCells = 0;
+    game.nFlags = 0;
+    game.nCorrectFlags = 0;
+    game.correctFlagsCounted = true;
+    game.minesPlaced = false;
+    game.clearStartBlockOnReveal = false;
+    game.mineCells.clear();
+    game.mineCellsListed = false;
+    game.nMines = std::min(difficulty.nMines, game.board.nCells);
+}
+
+void newGameWithMines(Game &game, Difficulty difficulty, uint64_t seed)
+{
+    newGame(game, difficulty, seed);
+
+    Random random;
+    seedRandom(random, seed);
+    placeMines(game.board, game.nMines, random);
+    computeAdjacentMineCounts(game.board);
+    setMinesPlaced(game);
+    // Made ahead of time anyway, so the list might as well be too.
+    listMines(game);
+    game.clearStartBlockOnReveal = true;
+}
+
+void startGameOnBoard(Game &game, Difficulty difficulty, uint64_t seed)
+{
+    game.difficulty = difficulty;
+    game.seed = seed;
+    game.status = GameStatus_Playing;
+    game.nOpenedCells = 0;
+    game.nFlags = countBits(game.board.flags);
+    game.clearStartBlockOnReveal = false;
+    setMinesPlaced(game);
+}
+
+void recountGame(Game &game)
+{
+    game.nOpenedCells = countBits(game.board.open);
+    game.nFlags = countBits(game.board.flags);
+    game.nCorrectFlags = 0;
+    game.correctFlagsCounted = !game.minesPlaced;
+    game.mineCells.clear();
+    game.mineCellsListed = false;
+
+    if (game.minesPlaced)
+    {
+        game.nMines = countBits(game.board.mines);
+    }
+    else
+    {
+        game.nMines = std::min(game.difficulty.nMines, game.board.nCells);
+    }
+}
+
+void applyCommand(Game &game, Command command, GameDelta &delta)
+{
+    Board &board = game.board;
+    int cellIndex = command.cellIndex;
+
+    delta.changedCells.clear();
+    delta.status = game.status;
+
+    if (game.status != GameStatus_Playing ||
+        cellIndex < 0 || cellIndex >= board.nCells ||
+        cellIsOpen(board, cellIndex) != (command.type == CommandType_Chord))
+    {
+        return;
+    }
+
+    switch (command.type)
+    {
+        case CommandType_Reveal:
+            if (cellHasFlag(board, cellIndex))
+            {
+                break;
+            }
+
+            if (!game.minesPlaced)
+            {
+                putMinesInNRandomCells(game, game.difficulty.nMines, cellIndex);
+            }
+            else if (game.clearStartBlockOnReveal)
+            {
+                clearStartBlock(game, cellIndex);
+            }
+
+            if (cellHasMine(board, cellIndex))
+            {
+                loseGame(game, delta);
+                break;
+            }
+
+            uncoverPartOfBoard(game, cellIndex, delta);
+            checkForWin(game, delta);
+            break;
+
+        case CommandType_Flag:
+            if (!cellHasFlag(board, cellIndex))
+            {
+                setBit(board.flags, cellIndex);
+                addFlag(game, cellIndex);
+                delta.changedCells.push_back(cellIndex);
+            }
+            break;
+
+        case CommandType_Unflag:
+            if (cellHasFlag(board, cellIndex))
+            {
+                clearBit(board.flags, cellIndex);
+                removeFlag(game, cellIndex);
+                delta.changedCells.push_back(cellIndex);
+            }
+            break;
+
+        case CommandType_Chord:
+            chordCell(game, cellIndex, delta);
+            break;
+
+        default:
+            break;
+    }
+
+    delta.status = game.status;
+}
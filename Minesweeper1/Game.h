@@ -0,0 +1,123 @@
+//
+//  Game.h
+//  Minesweeper1
+//
+
+#ifndef Game_h
+#define Game_h
+
+#include <stdint.h>
+#include <vector>
+
+#include "Board.h"
+
+// The rules of the game without any of the SDL front end: commands go in,
+// the cells they changed come out.  Nothing in here knows about windows,
+// pixels or the mouse, so it can be driven by a bot as fast as it can go.
+
+typedef struct
+{
+    int nRows;
+    int nCols;
+    int nMines;
+} Difficulty;
+
+static const Difficulty DIFFICULTY_EASY = { 16, 16, 24 };
+static const Difficulty DIFFICULTY_MEDIUM = { 32, 32, 100 };
+static const Difficulty DIFFICULTY_HARD = { 64, 64, 400 };
+
+typedef enum
+{
+    GameStatus_Playing,
+    GameStatus_Lost,
+    GameStatus_Won
+} GameStatus;
+
+typedef enum
+{
+    CommandType_Reveal,
+    CommandType_Flag,
+    CommandType_Unflag,
+    // On an open number with that many flags around it, reveals every other
+    // closed neighbour in one go.  Anything else does nothing.
+    CommandType_Chord
+} CommandType;
+
+typedef struct
+{
+    CommandType type;
+    int cellIndex;
+} Command;
+
+// What a command did.  Reuse one between commands, the vector keeps its
+// capacity.
+typedef struct
+{
+    // Every cell whose open or flag state changed, in the order it changed.
+    std::vector<int> changedCells;
+    GameStatus status;
+} GameDelta;
+
+typedef struct
+{
+    Difficulty difficulty;
+    uint64_t seed;
+    Board board;
+    GameStatus status;
+    // newGameWithMines lays the mines out up front, and the first reveal
+    // only moves any out of the 3x3 block around it.  After newGame they
+    // go down on the first reveal, around whatever was clicked.
+    bool minesPlaced;
+    int nMines;
+    // Kept up to date by every command, so nothing has to count the board.
+    int nOpenedCells;
+    int nFlags;
+    // Flags on mines.  Only meaningful once the mines are placed.  A loaded
+    // game leaves it to getCorrectFlags to count, like the mine list.
+    int nCorrectFlags;
+    bool correctFlagsCounted;
+    // Laid out by newGameWithMines: the first reveal still has to move the
+    // mines out of the block around it.
+    bool clearStartBlockOnReveal;
+    // Every mine, for opening them all at the end.  Only listed once
+    // something needs it, so loading or starting a game doesn't walk the
+    // mine bitplane.
+    std::vector<int> mineCells;
+    bool mineCellsListed;
+    FloodFill floodFill;
+} Game;
+
+// What the header counts down: mines minus flags, negative when there are
+// too many flags.
+inline int getMinesLeft(const Game &game)
+{
+    return game.nMines - game.nFlags;
+}
+
+// Counts them the first time after a load, after that it's kept up to date.
+int getCorrectFlags(Game &game);
+
+// An empty board for the difficulty.  The mines are placed by the first
+// reveal, keeping the revealed cell and its neighbours clear, so the first
+// click always opens onto a zero.  The same seed and first click always
+// give the same board.
+void newGame(Game &game, Difficulty difficulty, uint64_t seed);
+// Lays the mines out from the seed straight away instead, so the whole
+// board can be made before anyone clicks (e.g. on a BoardPool's thread).
+// The first reveal moves whatever mines are in the 3x3 block around it to
+// free cells elsewhere, so it still opens onto a zero.  Not the same board
+// as newGame gives for the seed and click, but just as repeatable.
+void newGameWithMines(Game &game, Difficulty difficulty, uint64_t seed);
+// Starts a game on game.board as it is, for boards laid out elsewhere
+// (e.g. the no-guess generator).  Mines and adjacency counts have to be in
+// place and nothing open yet.  The first reveal won't move anything.
+void startGameOnBoard(Game &game, Difficulty difficulty, uint64_t seed);
+// Works the counters out again from the bitplanes, for a game whose board
+// was filled in directly (e.g. loaded from a save).  difficulty and
+// minesPlaced have to be set already.
+void recountGame(Game &game);
+// Commands on a finished game, out of range cells, open cells (except for
+// chords) or (for reveals) flagged cells do nothing.
+void applyCommand(Game &game, Command command, GameDelta &delta);
+
+#endif /* Game_h */
@@ -0,0 +1,188 @@
+//
+//  Generator.cpp
+//  Minesweeper1
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <mutex>
+
+#include "Generator.h"
+#include "Solver.h"
+
+typedef struct
+{
+    Difficulty difficulty;
+    int startCellIndex;
+    uint64_t seed;
+    std::atomic<int> nextCandidate;
+    std::atomic<int> winningCandidate;
+    std::mutex winnerMutex;
+    Board *winner;
+} NoGuessSearch;
+
+// What one worker reuses from candidate to candidate.
+typedef struct
+{
+    Board board;
+    Solver solver;
+    FloodFill fill;
+} NoGuessWorker;
+
+static void layOutCandidate(const NoGuessSearch &search, int candidateIndex, Board &board)
+{
+    Random random;
+    seedRandom(random, search.seed + (uint64_t)candidateIndex * 0x9e3779b97f4a7c15ULL);
+
+    initBoard(board, search.difficulty.nCols, search.difficulty.nRows);
+    placeMinesAvoiding(board, search.difficulty.nMines, random, search.startCellIndex);
+    computeAdjacentMineCounts(board);
+}
+
+// Plays the board with the solver.  Gives up as soon as the solver is stuck
+// or a lower numbered candidate has already won.
+static bool isSolvableWithoutGuessing(NoGuessSearch &search, int candidateIndex, NoGuessWorker &worker)
+{
+    Board &board = worker.board;
+    Solver &solver = worker.solver;
+    int nMines = countBits(board.mines);
+    int nSafe = board.nCells - nMines;
+
+    initSolver(solver, board);
+    int nOpened = floodOpen(board, search.startCellIndex, worker.fill);
+    updateSolver(solver, board, worker.fill.openedCells);
+
+    while (nOpened < nSafe)
+    {
+        if (search.winningCandidate.load(std::memory_order_relaxed) < candidateIndex)
+        {
+            return false;
+        }
+
+        solve(solver, board);
+
+        int cellIndex = getNextSafeCell(solver, board);
+
+        if (cellIndex >= 0)
+        {
+            nOpened += floodOpen(board, cellIndex, worker.fill);
+            updateSolver(solver, board, worker.fill.openedCells);
+            continue;
+        }
+
+        // The only thing the solver doesn't know is the mine count: if every
+        // unknown cell is a mine, or none are, the board is done.
+        int nMinesLeft = nMines - solver.nKnownMines;
+        int nUnknown = board.nCells - nOpened - solver.nKnownMines;
+
+        return nMinesLeft == 0 || nMinesLeft == nUnknown;
+    }
+
+    return true;
+}
+
+static void searchForNoGuessBoard(NoGuessSearch &search)
+{
+    NoGuessWorker worker;
+
+    while (true)
+    {
+        int candidateIndex = search.nextCandidate.fetch_add(1);
+
+        if (candidateIndex >= NO_GUESS_MAX_CANDIDATES ||
+            candidateIndex > search.winningCandidate.load())
+        {
+            return;
+        }
+
+        layOutCandidate(search, candidateIndex, worker.board);
+
+        if (!isSolvableWithoutGuessing(search, candidateIndex, worker))
+        {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(search.winnerMutex);
+
+        if (candidateIndex < search.winningCandidate.load())
+        {
+            // Verifying opened cells, so lay it out again for the caller.
+            layOutCandidate(search, candidateIndex, *search.winner);
+            search.winningCandidate.store(candidateIndex);
+        }
+    }
+}
+
+bool generateNoGuessBoard(Board &board,
+                          Difficulty difficulty,
+                          int startCellIndex,
+                          uint64_t seed,
+                          WorkPool *pool,
+                          NoGuessStats *stats)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    NoGuessSearch search;
+    search.difficulty = difficulty;
+    search.startCellIndex = startCellIndex;
+    search.seed = seed;
+    search.nextCandidate.store(0);
+    search.winningCandidate.store(INT_MAX);
+    search.winner = &board;
+
+    if (pool != nullptr)
+    {
+        WorkGroup group;
+        initWorkGroup(group);
+
+        // The calling thread helps out while it waits, so that's one more.
+        int nWorkers = getWorkPoolThreadCount(*pool) + 1;
+
+        for (int workerIndex = 0; workerIndex < nWorkers; workerIndex++)
+        {
+            submitWork(*pool, group, [&search]() {
+                searchForNoGuessBoard(search);
+            });
+        }
+
+        waitForWorkGroup(*pool, group);
+    }
+    else
+    {
+        searchForNoGuessBoard(search);
+    }
+
+    bool found = search.winningCandidate.load() != INT_MAX;
+
+    if (!found)
+    {
+        layOutCandidate(search, 0, board);
+    }
+
+    if (stats != nullptr)
+    {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        stats->nCandidates = std::min(search.nextCandidate.load(), NO_GUESS_MAX_CANDIDATES);
+        stats->winningCandidate = found ? search.winningCandidate.load() : -1;
+        stats->milliseconds = elapsed.count();
+    }
+
+    return found;
+}
+
+int getNoGuessStartCell(Difficulty difficulty)
+{
+    return (difficulty.nRows / 2) * difficulty.nCols + difficulty.nCols / 2;
+}
+
+void placeNoGuessMines(Game &game, int startCellIndex, WorkPool *pool, NoGuessStats *stats)
+{
+    BitPlane flags = game.board.flags;
+
+    generateNoGuessBoard(game.board, game.difficulty, startCellIndex, game.seed, pool, stats);
+    game.board.flags = flags;
+    startGameOnBoard(game, game.difficulty, game.seed);
+}
@@ -0,0 +1,50 @@
+//
+//  Generator.h
+//  Minesweeper1
+//
+
+#ifndef Generator_h
+#define Generator_h
+
+#include <stdint.h>
+
+#include "Board.h"
+#include "Game.h"
+#include "WorkPool.h"
+
+// No-guess boards: random layouts with the start cell's block kept clear,
+// kept only if the solver can open every safe cell from the start cell
+// without ever guessing.
+//
+// Candidates are numbered and each one gets its own seed, so workers pull
+// the next number, lay it out and verify it without waiting on each other.
+// The lowest numbered candidate that passes wins, which keeps a seed giving
+// the same board however many threads there are.  As soon as one passes,
+// every higher numbered candidate still being verified gives up.
+
+static const int NO_GUESS_MAX_CANDIDATES = 4096;
+
+typedef struct
+{
+    // Candidates laid out, including the ones that were abandoned.
+    int nCandidates;
+    // -1 if none of them passed.
+    int winningCandidate;
+    double milliseconds;
+} NoGuessStats;
+
+// Falls back to candidate 0, which still has a safe start cell, if nothing
+// passes within NO_GUESS_MAX_CANDIDATES.  pool may be nullptr.
+bool generateNoGuessBoard(Board &board,
+                          Difficulty difficulty,
+                          int startCellIndex,
+                          uint64_t seed,
+                          WorkPool *pool,
+                          NoGuessStats *stats);
+// The middle of the board, a start cell for when there is no click yet.
+int getNoGuessStartCell(Difficulty difficulty);
+// Lays out a no-guess board for a game that hasn't placed its mines yet,
+// starting from the cell about to be revealed.  Flags already down stay.
+void placeNoGuessMines(Game &game, int startCellIndex, WorkPool *pool, NoGuessStats *stats);
+
+#endif /* Generator_h */
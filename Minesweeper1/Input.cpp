@@ -0,0 +1,45 @@
+//
+//  Input.cpp
+//  Minesweeper1
+//
+
+#include "Input.h"
+
+void clearInputQueue(InputQueue &queue)
+{
+    queue.head = 0;
+    queue.tail = 0;
+    queue.nDropped = 0;
+}
+
+bool pushInputEvent(InputQueue &queue, InputEvent event)
+{
+    if (queue.tail - queue.head == INPUT_QUEUE_SIZE)
+    {
+        queue.nDropped++;
+        return false;
+    }
+
+    queue.events[queue.tail & (INPUT_QUEUE_SIZE - 1)] = event;
+    queue.tail++;
+
+    return true;
+}
+
+bool popInputEvent(InputQueue &queue, InputEvent &event)
+{
+    if (queue.head == queue.tail)
+    {
+        return false;
+    }
+
+    event = queue.events[queue.head & (INPUT_QUEUE_SIZE - 1)];
+    queue.head++;
+
+    return true;
+}
+
+int getInputQueueLength(const InputQueue &queue)
+{
+    return (int)(queue.tail - queue.head);
+}
@@ -0,0 +1,60 @@
+//
+//  Input.h
+//  Minesweeper1
+//
+
+#ifndef Input_h
+#define Input_h
+
+#include <stdint.h>
+
+// Button presses and releases in the order they happened, stamped with the
+// time the event came in.  The game drains the queue once per update and
+// turns each press into exactly one action, however long it's held.
+
+typedef enum
+{
+    InputEventType_Press,
+    InputEventType_Release
+} InputEventType;
+
+typedef enum
+{
+    InputButton_Left,
+    InputButton_Right,
+    InputButton_Middle,
+    // The F key, which switches between clearing and flagging.
+    InputButton_ToggleMode
+} InputButton;
+
+typedef struct
+{
+    InputEventType type;
+    InputButton button;
+    // Where the mouse was when it happened, not where it is when the
+    // event gets handled.
+    int x;
+    int y;
+    uint32_t timestamp;
+} InputEvent;
+
+// Has to be a power of two.
+static const uint32_t INPUT_QUEUE_SIZE = 256;
+
+// A ring buffer.  head and tail only ever count up, the slot is the count
+// masked by the size.
+typedef struct
+{
+    InputEvent events[INPUT_QUEUE_SIZE];
+    uint32_t head = 0;
+    uint32_t tail = 0;
+    int nDropped = 0;
+} InputQueue;
+
+void clearInputQueue(InputQueue &queue);
+// Returns false, and counts the event as dropped, if the queue is full.
+bool pushInputEvent(InputQueue &queue, InputEvent event);
+bool popInputEvent(InputQueue &queue, InputEvent &event);
+int getInputQueueLength(const InputQueue &queue);
+
+#endif /* Input_h */
@@ -0,0 +1,652 @@
+//
+//  Probability.cpp
+//  Minesweeper1
+//
+
+#include <algorithm>
+#include <math.h>
+
+#include "Probability.h"
+
+typedef struct
+{
+    ProbabilityComponent *component;
+    // Mines on each constraint so far, and how many of its cells are still
+    // undecided.
+    std::vector<int> nMinesPlaced;
+    std::vector<int> nUndecided;
+    std::vector<char> isMine;
+    int nMines;
+    int nNodes;
+} Enumeration;
+
+static double logChoose(int n, int k)
+{
+    if (k < 0 || k > n)
+    {
+        return -INFINITY;
+    }
+
+    return lgamma(n + 1.0) - lgamma(k + 1.0) - lgamma(n - k + 1.0);
+}
+
+static bool setCellValue(Enumeration &enumeration, int cellIndex, int value)
+{
+    ProbabilityComponent &component = *enumeration.component;
+    bool feasible = true;
+
+    for (int i = component.cellConstraintStart[cellIndex];
+         i < component.cellConstraintStart[cellIndex + 1];
+         i++)
+    {
+        int constraintIndex = component.cellConstraints[i];
+        int need = component.constraints[constraintIndex].nMinesLeft;
+
+        enumeration.nMinesPlaced[constraintIndex] += value;
+        enumeration.nUndecided[constraintIndex]--;
+
+        if (enumeration.nMinesPlaced[constraintIndex] > need ||
+            enumeration.nMinesPlaced[constraintIndex] + enumeration.nUndecided[constraintIndex] < need)
+        {
+            feasible = false;
+        }
+    }
+
+    enumeration.isMine[cellIndex] = (char)value;
+    enumeration.nMines += value;
+
+    return feasible;
+}
+
+static void unsetCellValue(Enumeration &enumeration, int cellIndex, int value)
+{
+    ProbabilityComponent &component = *enumeration.component;
+
+    for (int i = component.cellConstraintStart[cellIndex];
+         i < component.cellConstraintStart[cellIndex + 1];
+         i++)
+    {
+        int constraintIndex = component.cellConstraints[i];
+        enumeration.nMinesPlaced[constraintIndex] -= value;
+        enumeration.nUndecided[constraintIndex]++;
+    }
+
+    enumeration.isMine[cellIndex] = 0;
+    enumeration.nMines -= value;
+}
+
+// Returns false once the node budget runs out.
+static bool enumerateFrom(Enumeration &enumeration, int cellIndex)
+{
+    ProbabilityComponent &component = *enumeration.component;
+    int nCells = (int)component.cells.size();
+
+    if (++enumeration.nNodes > PROBABILITY_NODE_BUDGET)
+    {
+        return false;
+    }
+
+    if (cellIndex == nCells)
+    {
+        int k = enumeration.nMines;
+        component.solutions[k] += 1.0;
+
+        for (int i = 0; i < nCells; i++)
+        {
+            if (enumeration.isMine[i])
+            {
+                component.mineCounts[i * (nCells + 1) + k] += 1.0;
+            }
+        }
+
+        return true;
+    }
+
+    for (int value = 0; value <= 1; value++)
+    {
+        bool feasible = setCellValue(enumeration, cellIndex, value);
+        bool finished = !feasible || enumerateFrom(enumeration, cellIndex + 1);
+        unsetCellValue(enumeration, cellIndex, value);
+
+        if (!finished)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Too many layouts to count: guess each cell from its tightest constraint
+// and pretend the component always uses the rounded sum of those.  Only
+// takes space for one value a cell.
+static void estimateComponent(ProbabilityComponent &component)
+{
+    int nCells = (int)component.cells.size();
+    double expectedMines = 0.0;
+
+    component.solutions.assign(nCells + 1, 0.0);
+    component.mineCounts.assign(nCells, 0.0);
+    component.exact = false;
+
+    for (int cellIndex = 0; cellIndex < nCells; cellIndex++)
+    {
+        double &estimate = component.mineCounts[cellIndex];
+
+        for (int i = component.cellConstraintStart[cellIndex];
+             i < component.cellConstraintStart[cellIndex + 1];
+             i++)
+        {
+            const ProbabilityConstraint &constraint =
+                component.constraints[component.cellConstraints[i]];
+            estimate = std::max(estimate, (double)constraint.nMinesLeft / constraint.nCells);
+        }
+
+        expectedMines += estimate;
+    }
+
+    int k = std::min((int)(expectedMines + 0.5), nCells);
+    component.solutions[k] = 1.0;
+    component.estimatedMines = k;
+}
+
+static void enumerateComponent(ProbabilityComponent &component)
+{
+    int nCells = (int)component.cells.size();
+
+    if (nCells > PROBABILITY_MAX_EXACT_CELLS)
+    {
+        estimateComponent(component);
+        return;
+    }
+
+    component.solutions.assign(nCells + 1, 0.0);
+    component.mineCounts.assign((size_t)nCells * (nCells + 1), 0.0);
+    component.exact = true;
+
+    Enumeration enumeration;
+    enumeration.component = &component;
+    enumeration.nMinesPlaced.assign(component.constraints.size(), 0);
+    enumeration.nUndecided.resize(component.constraints.size());
+    enumeration.isMine.assign(nCells, 0);
+    enumeration.nMines = 0;
+    enumeration.nNodes = 0;
+
+    for (int constraintIndex = 0;
+         constraintIndex < component.constraints.size();
+         constraintIndex++)
+    {
+        enumeration.nUndecided[constraintIndex] = component.constraints[constraintIndex].nCells;
+    }
+
+    if (!enumerateFrom(enumeration, 0))
+    {
+        estimateComponent(component);
+        return;
+    }
+
+    // Layout counts grow exponentially with the component, keep them small.
+    double biggest = *std::max_element(component.solutions.begin(), component.solutions.end());
+
+    if (biggest > 0.0)
+    {
+        for (int k = 0; k < component.solutions.size(); k++)
+        {
+            component.solutions[k] /= biggest;
+        }
+
+        for (int i = 0; i < component.mineCounts.size(); i++)
+        {
+            component.mineCounts[i] /= biggest;
+        }
+    }
+}
+
+// Walks from one frontier cell through the constraints it shares with other
+// cells, so every component's cells come out next to their neighbours.
+static void buildComponent(ProbabilityMap &map,
+                           const Solver &solver,
+                           const Board &board,
+                           int firstCell,
+                           ProbabilityComponent &component)
+{
+    int componentIndex = map.nComponents;
+    std::vector<int> &localIndex = map.localIndex;
+    std::vector<int> &constraintIndexOf = map.constraintIndexOf;
+
+    component.cells.clear();
+    component.constraints.clear();
+    component.cellConstraintStart.clear();
+    component.cellConstraints.clear();
+
+    std::vector<int> constraintCells;
+
+    map.componentOf[firstCell] = componentIndex;
+    component.cells.push_back(firstCell);
+
+    for (int queueHead = 0;
+         queueHead < component.cells.size();
+         queueHead++)
+    {
+        int cellIndex = component.cells[queueHead];
+        localIndex[cellIndex] = queueHead;
+
+        int cellX = getCellX(board, cellIndex);
+        int cellY = getCellY(board, cellIndex);
+
+        for (int y = std::max(cellY - 1, 0); y <= std::min(cellY + 1, board.height - 1); y++)
+        {
+            for (int x = std::max(cellX - 1, 0); x <= std::min(cellX + 1, board.width - 1); x++)
+            {
+                int constraintCell = getCellIndex(board, x, y);
+
+                if (!getBit(solver.isConstraint, constraintCell) ||
+                    constraintIndexOf[constraintCell] >= 0)
+                {
+                    continue;
+                }
+
+                constraintIndexOf[constraintCell] = (int)constraintCells.size();
+                constraintCells.push_back(constraintCell);
+
+                int constraintX = x;
+                int constraintY = y;
+
+                for (int ny = std::max(constraintY - 1, 0); ny <= std::min(constraintY + 1, board.height - 1); ny++)
+                {
+                    for (int nx = std::max(constraintX - 1, 0); nx <= std::min(constraintX + 1, board.width - 1); nx++)
+                    {
+                        int neighbourIndex = getCellIndex(board, nx, ny);
+
+                        if (isUnknownCell(solver, board, neighbourIndex) &&
+                            map.componentOf[neighbourIndex] < 0)
+                        {
+                            map.componentOf[neighbourIndex] = componentIndex;
+                            component.cells.push_back(neighbourIndex);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    int nCells = (int)component.cells.size();
+    std::vector<int> nCellConstraints(nCells + 1, 0);
+
+    for (int constraintIndex = 0;
+         constraintIndex < constraintCells.size();
+         constraintIndex++)
+    {
+        int constraintCell = constraintCells[constraintIndex];
+        int constraintX = getCellX(board, constraintCell);
+        int constraintY = getCellY(board, constraintCell);
+
+        ProbabilityConstraint constraint;
+        constraint.nMinesLeft = getAdjacentMines(board, constraintCell);
+        constraint.nCells = 0;
+
+        for (int y = std::max(constraintY - 1, 0); y <= std::min(constraintY + 1, board.height - 1); y++)
+        {
+            for (int x = std::max(constraintX - 1, 0); x <= std::min(constraintX + 1, board.width - 1); x++)
+            {
+                int neighbourIndex = getCellIndex(board, x, y);
+
+                if (isKnownMine(solver, neighbourIndex))
+                {
+                    constraint.nMinesLeft--;
+                }
+                else if (isUnknownCell(solver, board, neighbourIndex))
+                {
+                    constraint.cells[constraint.nCells++] = localIndex[neighbourIndex];
+                    nCellConstraints[localIndex[neighbourIndex] + 1]++;
+                }
+            }
+        }
+
+        component.constraints.push_back(constraint);
+        constraintIndexOf[constraintCell] = -1;
+    }
+
+    // Counting sort of the constraints by cell.
+    component.cellConstraintStart.assign(nCells + 1, 0);
+
+    for (int cellIndex = 0; cellIndex < nCells; cellIndex++)
+    {
+        component.cellConstraintStart[cellIndex + 1] =
+            component.cellConstraintStart[cellIndex] + nCellConstraints[cellIndex + 1];
+    }
+
+    component.cellConstraints.resize(component.cellConstraintStart[nCells]);
+    std::vector<int> fill(component.cellConstraintStart.begin(),
+                          component.cellConstraintStart.end() - 1);
+
+    for (int constraintIndex = 0;
+         constraintIndex < component.constraints.size();
+         constraintIndex++)
+    {
+        const ProbabilityConstraint &constraint = component.constraints[constraintIndex];
+
+        for (int i = 0; i < constraint.nCells; i++)
+        {
+            component.cellConstraints[fill[constraint.cells[i]]++] = constraintIndex;
+        }
+    }
+}
+
+// out = a * b as polynomials in the number of mines.
+static void convolve(const std::vector<double> &a,
+                     const std::vector<double> &b,
+                     std::vector<double> &out)
+{
+    out.assign(a.size() + b.size() - 1, 0.0);
+
+    for (int i = 0; i < a.size(); i++)
+    {
+        if (a[i] == 0.0)
+        {
+            continue;
+        }
+
+        for (int j = 0; j < b.size(); j++)
+        {
+            out[i + j] += a[i] * b[j];
+        }
+    }
+}
+
+// Closed cells that are neither known mines nor known safe, a word at a
+// time.
+static int countUnknownCells(const Solver &solver, const Board &board)
+{
+    int count = 0;
+
+    for (int wordIndex = 0;
+         wordIndex < board.open.size();
+         wordIndex++)
+    {
+        uint64_t unknown = ~(board.open[wordIndex] | solver.knownMines[wordIndex] | solver.knownSafe[wordIndex]);
+
+        if (wordIndex == board.open.size() - 1 && board.nCells % BITPLANE_WORD_BITS != 0)
+        {
+            unknown &= ((uint64_t)1 << (board.nCells % BITPLANE_WORD_BITS)) - 1;
+        }
+
+        count += __builtin_popcountll(unknown);
+    }
+
+    return count;
+}
+
+// The lowest unknown cell outside every component, -1 if there is none.
+static int findFirstInteriorCell(const ProbabilityMap &map, const Solver &solver, const Board &board)
+{
+    for (int wordIndex = 0;
+         wordIndex < board.open.size();
+         wordIndex++)
+    {
+        uint64_t unknown = ~(board.open[wordIndex] | solver.knownMines[wordIndex] | solver.knownSafe[wordIndex]);
+
+        while (unknown != 0)
+        {
+            int cellIndex = wordIndex * BITPLANE_WORD_BITS + __builtin_ctzll(unknown);
+            unknown &= unknown - 1;
+
+            if (cellIndex >= board.nCells)
+            {
+                return -1;
+            }
+
+            if (map.componentOf[cellIndex] < 0)
+            {
+                return cellIndex;
+            }
+        }
+    }
+
+    return -1;
+}
+
+void computeMineProbabilities(ProbabilityMap &map,
+                              Solver &solver,
+                              const Board &board,
+                              int nMines,
+                              WorkPool *pool)
+{
+    if (map.componentOf.size() != board.nCells)
+    {
+        map.probabilities.assign(board.nCells, 0.0f);
+        map.componentOf.assign(board.nCells, -1);
+        map.localIndex.assign(board.nCells, -1);
+        map.constraintIndexOf.assign(board.nCells, -1);
+    }
+    else
+    {
+        // Only the last call's frontier is marked.
+        for (int componentIndex = 0; componentIndex < map.nComponents; componentIndex++)
+        {
+            const std::vector<int> &cells = map.components[componentIndex].cells;
+
+            for (int i = 0; i < cells.size(); i++)
+            {
+                map.componentOf[cells[i]] = -1;
+            }
+        }
+    }
+
+    map.nComponents = 0;
+    map.interiorProbability = 0.0f;
+    map.exact = true;
+    map.bestGuessCell = -1;
+
+    const std::vector<int> &constraints = getFrontierConstraints(solver, board);
+
+    for (int constraintIndex = 0;
+         constraintIndex < constraints.size();
+         constraintIndex++)
+    {
+        int constraintCell = constraints[constraintIndex];
+        int constraintX = getCellX(board, constraintCell);
+        int constraintY = getCellY(board, constraintCell);
+
+        for (int y = std::max(constraintY - 1, 0); y <= std::min(constraintY + 1, board.height - 1); y++)
+        {
+            for (int x = std::max(constraintX - 1, 0); x <= std::min(constraintX + 1, board.width - 1); x++)
+            {
+                int cellIndex = getCellIndex(board, x, y);
+
+                if (isUnknownCell(solver, board, cellIndex) && map.componentOf[cellIndex] < 0)
+                {
+                    if (map.nComponents == map.components.size())
+                    {
+                        map.components.resize(map.nComponents + 1);
+                    }
+
+                    buildComponent(map, solver, board, cellIndex,
+                                   map.components[map.nComponents]);
+                    map.nComponents++;
+                }
+            }
+        }
+    }
+
+    if (pool != nullptr && map.nComponents > 1)
+    {
+        WorkGroup group;
+        initWorkGroup(group);
+
+        for (int componentIndex = 0; componentIndex < map.nComponents; componentIndex++)
+        {
+            ProbabilityComponent *component = &map.components[componentIndex];
+            submitWork(*pool, group, [component]() {
+                enumerateComponent(*component);
+            });
+        }
+
+        waitForWorkGroup(*pool, group);
+    }
+    else
+    {
+        for (int componentIndex = 0; componentIndex < map.nComponents; componentIndex++)
+        {
+            enumerateComponent(map.components[componentIndex]);
+        }
+    }
+
+    int nUnknown = countUnknownCells(solver, board);
+    int nFrontier = 0;
+
+    for (int componentIndex = 0; componentIndex < map.nComponents; componentIndex++)
+    {
+        nFrontier += (int)map.components[componentIndex].cells.size();
+    }
+
+    if (nUnknown == 0)
+    {
+        return;
+    }
+
+    int nInterior = nUnknown - nFrontier;
+    int nMinesLeft = nMines - solver.nKnownMines;
+
+    // Mine count distribution of all the components except one, for each
+    // one: prefix and suffix products so it's two passes, not n.
+    std::vector<std::vector<double>> prefix(map.nComponents + 1);
+    std::vector<std::vector<double>> suffix(map.nComponents + 1);
+    prefix[0].assign(1, 1.0);
+    suffix[map.nComponents].assign(1, 1.0);
+
+    for (int componentIndex = 0; componentIndex < map.nComponents; componentIndex++)
+    {
+        // Solutions first, its zeros are skipped, and an estimate is all zeros
+        // but one.
+        convolve(map.components[componentIndex].solutions, prefix[componentIndex],
+                 prefix[componentIndex + 1]);
+        map.exact = map.exact && map.components[componentIndex].exact;
+    }
+
+    for (int componentIndex = map.nComponents - 1; componentIndex >= 0; componentIndex--)
+    {
+        convolve(map.components[componentIndex].solutions, suffix[componentIndex + 1],
+                 suffix[componentIndex]);
+    }
+
+    // interiorWeights[t]: ways to put the remaining mines in the interior
+    // when the frontier holds t, relative to the largest.
+    const std::vector<double> &total = prefix[map.nComponents];
+    std::vector<double> interiorWeights(total.size(), 0.0);
+    double biggestLog = -INFINITY;
+
+    for (int t = 0; t < total.size(); t++)
+    {
+        biggestLog = std::max(biggestLog, logChoose(nInterior, nMinesLeft - t));
+    }
+
+    if (biggestLog == -INFINITY)
+    {
+        // The mine count can't be met, e.g. nMines doesn't match the board.
+        biggestLog = 0.0;
+    }
+
+    double totalWeight = 0.0;
+    double interiorMineWeight = 0.0;
+
+    for (int t = 0; t < total.size(); t++)
+    {
+        interiorWeights[t] = exp(logChoose(nInterior, nMinesLeft - t) - biggestLog);
+        totalWeight += total[t] * interiorWeights[t];
+
+        if (nInterior > 0)
+        {
+            interiorMineWeight += total[t] * interiorWeights[t] * (nMinesLeft - t) / nInterior;
+        }
+    }
+
+    if (totalWeight <= 0.0)
+    {
+        // Nothing fits, e.g. nMines doesn't match the board.
+        for (int componentIndex = 0; componentIndex < map.nComponents; componentIndex++)
+        {
+            const std::vector<int> &cells = map.components[componentIndex].cells;
+
+            for (int i = 0; i < cells.size(); i++)
+            {
+                map.probabilities[cells[i]] = 0.0f;
+            }
+        }
+
+        return;
+    }
+
+    for (int componentIndex = 0; componentIndex < map.nComponents; componentIndex++)
+    {
+        const ProbabilityComponent &component = map.components[componentIndex];
+        int nCells = (int)component.cells.size();
+
+        std::vector<double> others;
+        convolve(prefix[componentIndex], suffix[componentIndex + 1], others);
+
+        // weightForK[k]: weight of everything else when this component uses k mines.
+        // An estimate only ever uses the one k.
+        std::vector<double> weightForK(nCells + 1, 0.0);
+        int firstK = component.exact ? 0 : component.estimatedMines;
+        int lastK = component.exact ? nCells : component.estimatedMines;
+
+        for (int k = firstK; k <= lastK; k++)
+        {
+            for (int j = 0; j < others.size() && k + j < interiorWeights.size(); j++)
+            {
+                weightForK[k] += others[j] * interiorWeights[k + j];
+            }
+        }
+
+        for (int cellIndex = 0; cellIndex < nCells; cellIndex++)
+        {
+            double mineWeight = 0.0;
+
+            if (!component.exact)
+            {
+                mineWeight = component.mineCounts[cellIndex] * weightForK[component.estimatedMines];
+            }
+
+            for (int k = 0; component.exact && k <= nCells; k++)
+            {
+                mineWeight += component.mineCounts[cellIndex * (nCells + 1) + k] * weightForK[k];
+            }
+
+            map.probabilities[component.cells[cellIndex]] = (float)(mineWeight / totalWeight);
+        }
+    }
+
+    map.interiorProbability = (float)(interiorMineWeight / totalWeight);
+
+    // The lowest cell of those least likely to be a mine.
+    float bestProbability = 2.0f;
+
+    for (int componentIndex = 0; componentIndex < map.nComponents; componentIndex++)
+    {
+        const std::vector<int> &cells = map.components[componentIndex].cells;
+
+        for (int i = 0; i < cells.size(); i++)
+        {
+            float probability = map.probabilities[cells[i]];
+
+            if (probability < bestProbability ||
+                (probability == bestProbability && cells[i] < map.bestGuessCell))
+            {
+                bestProbability = probability;
+                map.bestGuessCell = cells[i];
+            }
+        }
+    }
+
+    if (nInterior > 0)
+    {
+        int interiorCell = findFirstInteriorCell(map, solver, board);
+
+        if (map.interiorProbability < bestProbability ||
+            (map.interiorProbability == bestProbability && interiorCell < map.bestGuessCell))
+        {
+            map.bestGuessCell = interiorCell;
+        }
+    }
+}
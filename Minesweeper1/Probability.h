@@ -0,0 +1,107 @@
+//
+//  Probability.h
+//  Minesweeper1
+//
+
+#ifndef Probability_h
+#define Probability_h
+
+#include <vector>
+
+#include "Board.h"
+#include "Solver.h"
+#include "WorkPool.h"
+
+// The chance that each closed cell is a mine, given what the player can see
+// and how many mines the board has.
+//
+// Unknown cells next to a constraint are split into components that share
+// no constraints, and every layout of each component that agrees with its
+// numbers is counted, grouped by how many mines it uses.  Components are
+// independent, so they are enumerated in parallel.  Cells away from the
+// frontier all share what's left, so the components are combined by
+// weighting each total by C(interior cells, mines left over).
+//
+// A component that would take more than PROBABILITY_NODE_BUDGET steps to
+// enumerate gets a local estimate instead, which keeps a call well inside
+// a frame on Hard.  So does one with more than PROBABILITY_MAX_EXACT_CELLS
+// cells, whose per-cell, per-mine-count table would be too big to hold
+// (it grows with the square of the size).
+//
+// Everything sized by the board is kept between calls and only the cells
+// the last call touched are reset, so a call costs about the frontier, not
+// the board.
+
+static const int PROBABILITY_NODE_BUDGET = 1 << 18;
+static const int PROBABILITY_MAX_EXACT_CELLS = 512;
+
+typedef struct
+{
+    int nMinesLeft;
+    int nCells;
+    int cells[8];
+} ProbabilityConstraint;
+
+typedef struct
+{
+    // Board indices, in the order they are enumerated.
+    std::vector<int> cells;
+    std::vector<ProbabilityConstraint> constraints;
+    // Constraints touching each cell: cellConstraints[cellConstraintStart[i]..
+    // cellConstraintStart[i + 1]).
+    std::vector<int> cellConstraintStart;
+    std::vector<int> cellConstraints;
+    // solutions[k] is the number of layouts using k mines, mineCounts[i * (n + 1) + k]
+    // how many of those put a mine on cell i.  Both are scaled so the
+    // biggest solutions[k] is 1.  An estimate only has layouts with
+    // estimatedMines mines, and mineCounts[i] is cell i's chance in them.
+    std::vector<double> solutions;
+    std::vector<double> mineCounts;
+    bool exact;
+    int estimatedMines;
+} ProbabilityComponent;
+
+typedef struct
+{
+    // Only set for frontier cells, see getMineProbability.
+    std::vector<float> probabilities;
+    // Every unknown cell away from the frontier.
+    float interiorProbability = 0.0f;
+    std::vector<ProbabilityComponent> components;
+    int nComponents = 0;
+    // Component of each frontier cell, -1 elsewhere.
+    std::vector<int> componentOf;
+    // Scratch for building components.
+    std::vector<int> localIndex;
+    std::vector<int> constraintIndexOf;
+    // False if any component was estimated.
+    bool exact = true;
+    // The closed cell least likely to be a mine, -1 if there is none.
+    int bestGuessCell = -1;
+} ProbabilityMap;
+
+// Call solve() first so the easy cells are already known.  pool may be
+// nullptr to do everything on the calling thread.
+void computeMineProbabilities(ProbabilityMap &map,
+                              Solver &solver,
+                              const Board &board,
+                              int nMines,
+                              WorkPool *pool);
+
+// 0 for open and known safe cells, 1 for known mines.
+inline float getMineProbability(const ProbabilityMap &map, const Solver &solver, const Board &board, int cellIndex)
+{
+    if (isKnownMine(solver, cellIndex))
+    {
+        return 1.0f;
+    }
+
+    if (!isUnknownCell(solver, board, cellIndex))
+    {
+        return 0.0f;
+    }
+
+    return map.componentOf[cellIndex] >= 0 ? map.probabilities[cellIndex] : map.interiorProbability;
+}
+
+#endif /* Probability_h */
@@ -0,0 +1,307 @@
+//
+//  Profile.cpp
+//  Minesweeper1
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+
+#include "Profile.h"
+
+static const std::chrono::steady_clock::time_point gProfileEpoch = std::chrono::steady_clock::now();
+// Only taken when a thread records its first event, names itself, or for
+// exporting.
+static std::mutex gProfileRingsMutex;
+static std::vector<std::unique_ptr<ProfileRing>> gProfileRings;
+static thread_local ProfileRing *tProfileRing = nullptr;
+
+static ProfileRing &getProfileRing()
+{
+    if (tProfileRing == nullptr)
+    {
+        // Zeroed, about 2 MB.
+        std::unique_ptr<ProfileRing> ring(new ProfileRing());
+        std::lock_guard<std::mutex> lock(gProfileRingsMutex);
+        ring->threadIndex = (int)gProfileRings.size();
+        tProfileRing = ring.get();
+        gProfileRings.push_back(std::move(ring));
+    }
+
+    return *tProfileRing;
+}
+
+// Appends the events from firstEvent on that are still in the ring and
+// returns how many events the ring had recorded.  Events the owning thread
+// writes over while they're being copied are dropped again afterwards.
+static uint64_t readProfileRing(const ProfileRing &ring, uint64_t firstEvent, std::vector<ProfileEvent> &out)
+{
+    uint64_t nEvents = ring.nEvents.load(std::memory_order_acquire);
+    uint64_t oldestEvent = nEvents > PROFILE_RING_EVENTS ? nEvents - PROFILE_RING_EVENTS : 0;
+    firstEvent = std::max(firstEvent, oldestEvent);
+    size_t outStart = out.size();
+
+    for (uint64_t eventIndex = firstEvent;
+         eventIndex < nEvents;
+         eventIndex++)
+    {
+        out.push_back(ring.events[eventIndex % PROFILE_RING_EVENTS]);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // The owner may already be partway through the slot after these.
+    uint64_t firstIntact = ring.nEvents.load(std::memory_order_relaxed) + 1;
+    firstIntact = firstIntact > PROFILE_RING_EVENTS ? firstIntact - PROFILE_RING_EVENTS : 0;
+
+    if (firstIntact > firstEvent)
+    {
+        size_t nLost = (size_t)std::min(firstIntact, nEvents) - firstEvent;
+        out.erase(out.begin() + outStart, out.begin() + outStart + nLost);
+    }
+
+    return nEvents;
+}
+
+int64_t getProfileTimeNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - gProfileEpoch).count();
+}
+
+void recordProfileEvent(const char *name, ProfileEventType type, int64_t startNs, int64_t value)
+{
+    ProfileRing &ring = getProfileRing();
+    uint64_t eventIndex = ring.nEvents.load(std::memory_order_relaxed);
+
+    ring.events[eventIndex % PROFILE_RING_EVENTS] = { name, type, startNs, value };
+    ring.nEvents.store(eventIndex + 1, std::memory_order_release);
+}
+
+void countProfileEvent(const char *name, int64_t n)
+{
+    ProfileRing &ring = getProfileRing();
+
+    // The same literal is usually the same pointer, so comparing the
+    // strings only happens the first time a call site counts.
+    for (int countIndex = 0; countIndex < ring.nCounts; countIndex++)
+    {
+        if (ring.counts[countIndex].name == name)
+        {
+            ring.counts[countIndex].value += n;
+            return;
+        }
+    }
+
+    for (int countIndex = 0; countIndex < ring.nCounts; countIndex++)
+    {
+        if (strcmp(ring.counts[countIndex].name, name) == 0)
+        {
+            ring.counts[countIndex].value += n;
+            return;
+        }
+    }
+
+    if (ring.nCounts < PROFILE_MAX_COUNTERS)
+    {
+        ring.counts[ring.nCounts++] = { name, n };
+    }
+}
+
+void flushProfileCounts()
+{
+    ProfileRing &ring = getProfileRing();
+    int64_t nowNs = getProfileTimeNs();
+
+    // Zeroes too, so a trace's counter tracks drop back down.
+    for (int countIndex = 0; countIndex < ring.nCounts; countIndex++)
+    {
+        recordProfileEvent(ring.counts[countIndex].name, ProfileEventType_Count, nowNs, ring.counts[countIndex].value);
+        ring.counts[countIndex].value = 0;
+    }
+}
+
+void nameProfileThread(const char *name)
+{
+    ProfileRing &ring = getProfileRing();
+    std::lock_guard<std::mutex> lock(gProfileRingsMutex);
+    ring.threadName = name;
+}
+
+static int findProfileSeries(ProfileWindow &window, const ProfileEvent &event)
+{
+    for (int seriesIndex = 0;
+         seriesIndex < window.series.size();
+         seriesIndex++)
+    {
+        const ProfileSeries &series = window.series[seriesIndex];
+
+        if (series.type == event.type && (series.name == event.name || strcmp(series.name, event.name) == 0))
+        {
+            return seriesIndex;
+        }
+    }
+
+    // Frames from before it was first seen count as 0.
+    ProfileSeries series;
+    series.name = event.name;
+    series.type = event.type;
+    std::fill(series.values, series.values + PROFILE_WINDOW_FRAMES, 0.0);
+    window.series.push_back(series);
+
+    return (int)window.series.size() - 1;
+}
+
+void initProfileWindow(ProfileWindow &window)
+{
+    window.series.clear();
+    window.nFrames = 0;
+    window.frameIndex = 0;
+    window.nEventsRead = getProfileRing().nEvents.load(std::memory_order_relaxed);
+}
+
+void endProfileFrame(ProfileWindow &window)
+{
+    window.newEvents.clear();
+    window.nEventsRead = readProfileRing(getProfileRing(), window.nEventsRead, window.newEvents);
+
+    for (int seriesIndex = 0;
+         seriesIndex < window.series.size();
+         seriesIndex++)
+    {
+        window.series[seriesIndex].values[window.frameIndex] = 0.0;
+    }
+
+    for (int eventIndex = 0;
+         eventIndex < window.newEvents.size();
+         eventIndex++)
+    {
+        const ProfileEvent &event = window.newEvents[eventIndex];
+        int seriesIndex = findProfileSeries(window, event);
+        ProfileSeries &series = window.series[seriesIndex];
+
+        series.values[window.frameIndex] += event.type == ProfileEventType_Scope ? event.value / 1000000.0 :
+                                                                                   (double)event.value;
+    }
+
+    window.frameIndex = (window.frameIndex + 1) % PROFILE_WINDOW_FRAMES;
+    window.nFrames = std::min(window.nFrames + 1, PROFILE_WINDOW_FRAMES);
+}
+
+// Nearest rank.  Until the window first fills, the frames so far are the
+// first nFrames slots.
+double getProfilePercentile(ProfileWindow &window, const ProfileSeries &series, double percentile)
+{
+    if (window.nFrames == 0)
+    {
+        return 0.0;
+    }
+
+    window.sorted.assign(series.values, series.values + window.nFrames);
+
+    int rank = (int)std::ceil(percentile * window.nFrames) - 1;
+    rank = std::max(0, std::min(rank, window.nFrames - 1));
+    std::nth_element(window.sorted.begin(), window.sorted.begin() + rank, window.sorted.end());
+
+    return window.sorted[rank];
+}
+
+static void writeJsonString(FILE *file, const char *text)
+{
+    fputc('"', file);
+
+    for (const char *c = text; *c != '\0'; c++)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            fputc('\\', file);
+            fputc(*c, file);
+        }
+        else if ((unsigned char)*c < 0x20)
+        {
+            fprintf(file, "\\u%04x", (unsigned char)*c);
+        }
+        else
+        {
+            fputc(*c, file);
+        }
+    }
+
+    fputc('"', file);
+}
+
+bool writeProfileTrace(const char *path)
+{
+    std::vector<const ProfileRing *> rings;
+    std::vector<const char *> threadNames;
+
+    {
+        std::lock_guard<std::mutex> lock(gProfileRingsMutex);
+
+        for (int ringIndex = 0;
+             ringIndex < gProfileRings.size();
+             ringIndex++)
+        {
+            rings.push_back(gProfileRings[ringIndex].get());
+            threadNames.push_back(gProfileRings[ringIndex]->threadName);
+        }
+    }
+
+    FILE *file = fopen(path, "w");
+
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    // Trace timestamps are in microseconds.
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Minesweeper1\"}}");
+
+    std::vector<ProfileEvent> events;
+
+    for (int ringIndex = 0;
+         ringIndex < rings.size();
+         ringIndex++)
+    {
+        int threadIndex = rings[ringIndex]->threadIndex;
+
+        if (threadNames[ringIndex] != nullptr)
+        {
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", threadIndex);
+            writeJsonString(file, threadNames[ringIndex]);
+            fprintf(file, "}}");
+        }
+
+        events.clear();
+        readProfileRing(*rings[ringIndex], 0, events);
+
+        for (int eventIndex = 0;
+             eventIndex < events.size();
+             eventIndex++)
+        {
+            const ProfileEvent &event = events[eventIndex];
+
+            fprintf(file, ",\n{\"name\":");
+            writeJsonString(file, event.name);
+
+            if (event.type == ProfileEventType_Scope)
+            {
+                fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                        threadIndex, event.startNs / 1000.0, event.value / 1000.0);
+            }
+            else
+            {
+                fprintf(file, ",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"value\":%lld}}",
+                        threadIndex, event.startNs / 1000.0, (long long)event.value);
+            }
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+
+    bool written = !ferror(file);
+    return fclose(file) == 0 && written;
+}
@@ -0,0 +1,140 @@
+//
+//  Profile.h
+//  Minesweeper1
+//
+
+#ifndef Profile_h
+#define Profile_h
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+// Scoped timers and counters for finding where a frame goes.
+//
+// PROFILE_SCOPE(name) times the rest of the enclosing block.  Each thread
+// writes its events to a ring of its own, so recording is two clock reads
+// and a store, no locks and no allocating after the thread's first event.
+// When a ring fills up the oldest events are written over.
+//
+// PROFILE_COUNT(name, n) adds n to a per-thread counter, e.g. for draw
+// calls.  flushProfileCounts turns the counts so far into one event each,
+// so a counter costs the same however often it's hit.
+//
+// Names must be string literals, or at least outlive the program: events
+// only keep the pointer.
+//
+// Building with -DMINESWEEPER_NO_PROFILER compiles every PROFILE_ macro
+// away.  The rest still links, it just never has anything to report.
+
+#ifndef MINESWEEPER_NO_PROFILER
+#define PROFILE_JOIN_NAMES(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN_NAMES(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_JOIN(profileScope, __LINE__)(name)
+#define PROFILE_COUNT(name, n) countProfileEvent(name, n)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNT(name, n) ((void)0)
+#endif
+
+// Power of two.  About a minute of frames at 60 fps.
+static const uint64_t PROFILE_RING_EVENTS = 1 << 16;
+static const int PROFILE_MAX_COUNTERS = 16;
+// How many frames the percentiles are taken over.
+static const int PROFILE_WINDOW_FRAMES = 120;
+
+typedef enum
+{
+    ProfileEventType_Scope,
+    ProfileEventType_Count
+} ProfileEventType;
+
+typedef struct
+{
+    const char *name;
+    ProfileEventType type;
+    // Nanoseconds since the profiler started.
+    int64_t startNs;
+    // How long a scope took, or a counter's value.
+    int64_t value;
+} ProfileEvent;
+
+typedef struct
+{
+    const char *name;
+    int64_t value;
+} ProfileCount;
+
+// One per thread that has recorded anything, kept until the program ends
+// so a finished thread's events can still be exported.
+typedef struct
+{
+    ProfileEvent events[PROFILE_RING_EVENTS];
+    // Events ever recorded.  Only the owning thread writes it; readers
+    // load it before and after copying to find what was written over
+    // meanwhile.
+    std::atomic<uint64_t> nEvents;
+    ProfileCount counts[PROFILE_MAX_COUNTERS];
+    int nCounts;
+    const char *threadName;
+    int threadIndex;
+} ProfileRing;
+
+int64_t getProfileTimeNs();
+void recordProfileEvent(const char *name, ProfileEventType type, int64_t startNs, int64_t value);
+void countProfileEvent(const char *name, int64_t n);
+// Records the calling thread's counters and zeroes them.
+void flushProfileCounts();
+// Shown in the trace instead of a number.
+void nameProfileThread(const char *name);
+
+struct ProfileScope
+{
+    const char *name;
+    int64_t startNs;
+
+    explicit ProfileScope(const char *scopeName) : name(scopeName), startNs(getProfileTimeNs())
+    {
+    }
+
+    ~ProfileScope()
+    {
+        recordProfileEvent(name, ProfileEventType_Scope, startNs, getProfileTimeNs() - startNs);
+    }
+};
+
+// One scope or counter's per-frame totals, oldest written over first.
+typedef struct
+{
+    const char *name;
+    ProfileEventType type;
+    double values[PROFILE_WINDOW_FRAMES];
+} ProfileSeries;
+
+// Rolling per-frame totals of the events one thread records, for an
+// overlay.  Nested scopes each count in full, so a scope's total includes
+// the scopes inside it.
+typedef struct
+{
+    std::vector<ProfileSeries> series;
+    int nFrames;
+    // Where the next frame goes in every series.
+    int frameIndex;
+    // How far into the thread's ring has been read.
+    uint64_t nEventsRead;
+    std::vector<ProfileEvent> newEvents;
+    std::vector<double> sorted;
+} ProfileWindow;
+
+void initProfileWindow(ProfileWindow &window);
+// Adds up everything the calling thread recorded since the last call as
+// one frame.  Scopes not hit in the frame count as 0 for it.
+void endProfileFrame(ProfileWindow &window);
+// percentile in 0..1.  Scope totals in milliseconds.
+double getProfilePercentile(ProfileWindow &window, const ProfileSeries &series, double percentile);
+
+// Every event still in any thread's ring, as Chrome trace event JSON
+// (chrome://tracing, Perfetto).  Counters come out as counter tracks.
+bool writeProfileTrace(const char *path);
+
+#endif /* Profile_h */
@@ -0,0 +1,73 @@
+//
+//  Random.cpp
+//  Minesweeper1
+//
+
+#include <random>
+
+#include "Random.h"
+
+static uint64_t splitMix64(uint64_t &state)
+{
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static uint64_t rotateLeft(uint64_t value, int shift)
+{
+    return (value << shift) | (value >> (64 - shift));
+}
+
+void seedRandom(Random &random, uint64_t seed)
+{
+    for (int stateIndex = 0; stateIndex < 4; stateIndex++)
+    {
+        random.state[stateIndex] = splitMix64(seed);
+    }
+}
+
+uint64_t nextRandom(Random &random)
+{
+    uint64_t *s = random.state;
+    uint64_t result = rotateLeft(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotateLeft(s[3], 45);
+
+    return result;
+}
+
+int randomInt(Random &random, int max)
+{
+    // Lemire's multiply-and-reject: take the high half of a 32x32 product
+    // and only retry in the rare case the low half lands in the biased zone.
+    uint32_t range = (uint32_t)max;
+    uint64_t product = (nextRandom(random) >> 32) * range;
+    uint32_t low = (uint32_t)product;
+
+    if (low < range)
+    {
+        uint32_t threshold = (0u - range) % range;
+
+        while (low < threshold)
+        {
+            product = (nextRandom(random) >> 32) * range;
+            low = (uint32_t)product;
+        }
+    }
+
+    return (int)(product >> 32);
+}
+
+uint64_t makeRandomSeed()
+{
+    std::random_device rd;
+    return ((uint64_t)rd() << 32) | rd();
+}
@@ -0,0 +1,25 @@
+//
+//  Random.h
+//  Minesweeper1
+//
+
+#ifndef Random_h
+#define Random_h
+
+#include <stdint.h>
+
+// xoshiro256** seeded through splitmix64.  Written out by hand instead of
+// using <random> so a seed gives the same board with every standard library.
+typedef struct
+{
+    uint64_t state[4];
+} Random;
+
+void seedRandom(Random &random, uint64_t seed);
+uint64_t nextRandom(Random &random);
+// Uniform in [0, max), no modulo bias.
+int randomInt(Random &random, int max);
+// A fresh seed from std::random_device, for when reproducibility doesn't matter.
+uint64_t makeRandomSeed();
+
+#endif /* Random_h */
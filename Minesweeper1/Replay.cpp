@@ -0,0 +1,314 @@
+//
+//  Replay.cpp
+//  Minesweeper1
+//
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Generator.h"
+#include "Replay.h"
+
+// Everything is written a byte at a time in little-endian order, so
+// archives move between machines.
+static void writeUint(uint8_t *out, uint64_t value, int nBytes)
+{
+    for (int byteIndex = 0; byteIndex < nBytes; byteIndex++)
+    {
+        out[byteIndex] = (uint8_t)(value >> (byteIndex * 8));
+    }
+}
+
+static uint64_t readUint(const uint8_t *in, int nBytes)
+{
+    uint64_t value = 0;
+
+    for (int byteIndex = 0; byteIndex < nBytes; byteIndex++)
+    {
+        value |= (uint64_t)in[byteIndex] << (byteIndex * 8);
+    }
+
+    return value;
+}
+
+static void writeVarint(std::vector<uint8_t> &out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+
+    out.push_back((uint8_t)value);
+}
+
+static bool readVarint(const uint8_t *&next, const uint8_t *end, uint64_t &value)
+{
+    value = 0;
+
+    for (int shift = 0; shift < 64 && next < end; shift += 7)
+    {
+        uint8_t byte = *next++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void writeHeader(const ReplayHeader &header, uint8_t *out)
+{
+    writeUint(out + 0, REPLAY_MAGIC, 4);
+    writeUint(out + 4, header.version, 2);
+    writeUint(out + 6, header.flags, 2);
+    writeUint(out + 8, header.seed, 8);
+    writeUint(out + 16, header.difficulty.nRows, 4);
+    writeUint(out + 20, header.difficulty.nCols, 4);
+    writeUint(out + 24, header.difficulty.nMines, 4);
+    writeUint(out + 28, header.status, 1);
+    writeUint(out + 29, 0, 3);
+    writeUint(out + 32, header.duration, 4);
+    writeUint(out + 36, header.nCommands, 4);
+}
+
+static bool readHeader(const uint8_t *in, ReplayHeader &header)
+{
+    if (readUint(in, 4) != REPLAY_MAGIC)
+    {
+        return false;
+    }
+
+    header.version = (uint16_t)readUint(in + 4, 2);
+    header.flags = (uint16_t)readUint(in + 6, 2);
+    header.seed = readUint(in + 8, 8);
+    header.difficulty.nRows = (int)readUint(in + 16, 4);
+    header.difficulty.nCols = (int)readUint(in + 20, 4);
+    header.difficulty.nMines = (int)readUint(in + 24, 4);
+    header.status = (GameStatus)readUint(in + 28, 1);
+    header.duration = (uint32_t)readUint(in + 32, 4);
+    header.nCommands = (uint32_t)readUint(in + 36, 4);
+
+    return header.version == REPLAY_VERSION;
+}
+
+void startRecording(ReplayRecorder &recorder, uint64_t seed, Difficulty difficulty, uint16_t flags)
+{
+    recorder.header.version = REPLAY_VERSION;
+    recorder.header.flags = flags;
+    recorder.header.seed = seed;
+    recorder.header.difficulty = difficulty;
+    recorder.header.status = GameStatus_Playing;
+    recorder.header.duration = 0;
+    recorder.header.nCommands = 0;
+    recorder.header.payloadSize = 0;
+    recorder.payload.clear();
+    recorder.lastTime = 0;
+}
+
+void recordCommand(ReplayRecorder &recorder, uint32_t time, Command command)
+{
+    writeVarint(recorder.payload, time - recorder.lastTime);
+    writeVarint(recorder.payload, ((uint64_t)command.cellIndex << 2) | command.type);
+    recorder.lastTime = time;
+    recorder.header.nCommands++;
+}
+
+void finishRecording(ReplayRecorder &recorder, GameStatus status)
+{
+    recorder.header.status = status;
+    recorder.header.duration = recorder.lastTime;
+    recorder.header.payloadSize = (uint32_t)recorder.payload.size();
+}
+
+void writeRecording(const ReplayRecorder &recorder, std::vector<uint8_t> &out)
+{
+    // The payload size is implied by the command count, the reader walks
+    // the varints to find the next record.
+    size_t start = out.size();
+    out.resize(start + REPLAY_HEADER_SIZE);
+    writeHeader(recorder.header, out.data() + start);
+    out.insert(out.end(), recorder.payload.begin(), recorder.payload.end());
+}
+
+bool appendRecording(const ReplayRecorder &recorder, const char *path)
+{
+    FILE *file = fopen(path, "ab");
+
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> record;
+    writeRecording(recorder, record);
+
+    bool written = fwrite(record.data(), 1, record.size(), file) == record.size();
+
+    return fclose(file) == 0 && written;
+}
+
+bool openReplayArchive(ReplayArchive &archive, const char *path)
+{
+    closeReplayArchive(archive);
+
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) < 0 || info.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void *data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    // Records are read front to back exactly once.
+    madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+
+    archive.data = (const uint8_t *)data;
+    archive.size = (size_t)info.st_size;
+    archive.offset = 0;
+
+    return true;
+}
+
+void closeReplayArchive(ReplayArchive &archive)
+{
+    if (archive.data != nullptr)
+    {
+        munmap((void *)archive.data, archive.size);
+    }
+
+    archive.data = nullptr;
+    archive.size = 0;
+    archive.offset = 0;
+}
+
+bool nextReplayRecord(ReplayArchive &archive, ReplayRecord &record)
+{
+    if (archive.size - archive.offset < (size_t)REPLAY_HEADER_SIZE ||
+        !readHeader(archive.data + archive.offset, record.header))
+    {
+        return false;
+    }
+
+    record.payload = archive.data + archive.offset + REPLAY_HEADER_SIZE;
+
+    // Skip over the commands: every byte without the top bit ends a varint,
+    // and each command is two of them.
+    const uint8_t *next = record.payload;
+    const uint8_t *end = archive.data + archive.size;
+    uint64_t nVarints = (uint64_t)record.header.nCommands * 2;
+
+    while (nVarints > 0 && next < end)
+    {
+        nVarints -= (*next++ & 0x80) == 0 ? 1 : 0;
+    }
+
+    if (nVarints > 0)
+    {
+        return false;
+    }
+
+    record.header.payloadSize = (uint32_t)(next - record.payload);
+    archive.offset = next - archive.data;
+
+    return true;
+}
+
+void startReplayCursor(ReplayCursor &cursor, const ReplayRecord &record)
+{
+    cursor.next = record.payload;
+    cursor.end = record.payload + record.header.payloadSize;
+    cursor.time = 0;
+    cursor.nLeft = record.header.nCommands;
+}
+
+bool peekReplayCommand(const ReplayCursor &cursor, ReplayCommand &command)
+{
+    ReplayCursor copy = cursor;
+    return nextReplayCommand(copy, command);
+}
+
+bool nextReplayCommand(ReplayCursor &cursor, ReplayCommand &command)
+{
+    uint64_t timeDelta;
+    uint64_t packed;
+
+    if (cursor.nLeft == 0 ||
+        !readVarint(cursor.next, cursor.end, timeDelta) ||
+        !readVarint(cursor.next, cursor.end, packed))
+    {
+        return false;
+    }
+
+    cursor.time += (uint32_t)timeDelta;
+    cursor.nLeft--;
+
+    command.time = cursor.time;
+    command.command.type = (CommandType)(packed & 3);
+    command.command.cellIndex = (int)(packed >> 2);
+
+    return true;
+}
+
+void startReplayGame(Game &game, const ReplayHeader &header)
+{
+    if (header.flags & REPLAY_FLAG_MINES_FIRST)
+    {
+        newGameWithMines(game, header.difficulty, header.seed);
+    }
+    else
+    {
+        newGame(game, header.difficulty, header.seed);
+    }
+}
+
+void sendReplayCommand(Game &game, const ReplayHeader &header, Command command, GameDelta &delta)
+{
+    // Same as the front end: a no-guess board is laid out on the first
+    // reveal, which doesn't depend on how many threads do it.
+    if ((header.flags & REPLAY_FLAG_NO_GUESS) && command.type == CommandType_Reveal &&
+        !game.minesPlaced && command.cellIndex >= 0 && command.cellIndex < game.board.nCells &&
+        !cellHasFlag(game.board, command.cellIndex))
+    {
+        placeNoGuessMines(game, command.cellIndex, nullptr, nullptr);
+    }
+
+    applyCommand(game, command, delta);
+}
+
+GameStatus replayGame(Game &game, GameDelta &delta, const ReplayRecord &record)
+{
+    ReplayCursor cursor;
+    ReplayCommand command;
+
+    startReplayGame(game, record.header);
+    startReplayCursor(cursor, record);
+
+    while (nextReplayCommand(cursor, command))
+    {
+        sendReplayCommand(game, record.header, command.command, delta);
+    }
+
+    return game.status;
+}
@@ -0,0 +1,104 @@
+//
+//  Replay.h
+//  Minesweeper1
+//
+
+#ifndef Replay_h
+#define Replay_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "Game.h"
+
+// A game is its seed, its difficulty, how its mines were laid out and
+// the commands that were sent to it, each stamped with the update it went
+// in on.  The engine is deterministic, so that replays the game exactly.
+//
+// An archive is just records one after the other, each a fixed header and
+// then the commands as varints: the updates since the previous command,
+// then cellIndex << 2 | type.  A typical command is two or three bytes.
+// The header carries the result too, so statistics over an archive don't
+// have to replay anything.
+
+static const uint32_t REPLAY_MAGIC = 0x5052534d;  // "MSRP"
+static const uint16_t REPLAY_VERSION = 1;
+static const int REPLAY_HEADER_SIZE = 40;
+static const uint16_t REPLAY_FLAG_NO_GUESS = 1;
+// Laid out by newGameWithMines rather than on the first reveal.
+static const uint16_t REPLAY_FLAG_MINES_FIRST = 2;
+
+typedef struct
+{
+    uint16_t version;
+    uint16_t flags;
+    uint64_t seed;
+    Difficulty difficulty;
+    GameStatus status;
+    // In updates, when the last command went in.
+    uint32_t duration;
+    uint32_t nCommands;
+    uint32_t payloadSize;
+} ReplayHeader;
+
+typedef struct
+{
+    uint32_t time;
+    Command command;
+} ReplayCommand;
+
+typedef struct
+{
+    ReplayHeader header;
+    std::vector<uint8_t> payload;
+    uint32_t lastTime;
+} ReplayRecorder;
+
+// flags are REPLAY_FLAG_*.
+void startRecording(ReplayRecorder &recorder, uint64_t seed, Difficulty difficulty, uint16_t flags);
+// time is the update the command went in on, and never goes backwards.
+void recordCommand(ReplayRecorder &recorder, uint32_t time, Command command);
+void finishRecording(ReplayRecorder &recorder, GameStatus status);
+// Appends the record to out, for writing many at once.
+void writeRecording(const ReplayRecorder &recorder, std::vector<uint8_t> &out);
+// Appends the record to the archive at path, creating it if needed.
+bool appendRecording(const ReplayRecorder &recorder, const char *path);
+
+// A whole archive mapped into memory.  Records are read in place.
+typedef struct
+{
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+    size_t offset = 0;
+} ReplayArchive;
+
+typedef struct
+{
+    ReplayHeader header;
+    const uint8_t *payload;
+} ReplayRecord;
+
+typedef struct
+{
+    const uint8_t *next;
+    const uint8_t *end;
+    uint32_t time;
+    uint32_t nLeft;
+} ReplayCursor;
+
+bool openReplayArchive(ReplayArchive &archive, const char *path);
+void closeReplayArchive(ReplayArchive &archive);
+// False at the end of the archive, or at a record that doesn't make sense.
+bool nextReplayRecord(ReplayArchive &archive, ReplayRecord &record);
+void startReplayCursor(ReplayCursor &cursor, const ReplayRecord &record);
+bool peekReplayCommand(const ReplayCursor &cursor, ReplayCommand &command);
+bool nextReplayCommand(ReplayCursor &cursor, ReplayCommand &command);
+// Starts the recorded game; commands then go through sendReplayCommand so
+// no-guess boards are laid out the way they were.
+void startReplayGame(Game &game, const ReplayHeader &header);
+void sendReplayCommand(Game &game, const ReplayHeader &header, Command command, GameDelta &delta);
+// Plays the whole record as fast as it goes and returns how it ended.
+GameStatus replayGame(Game &game, GameDelta &delta, const ReplayRecord &record);
+
+#endif /* Replay_h */
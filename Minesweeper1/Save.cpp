@@ -0,0 +1,238 @@
+//
+//  Save.cpp
+//  Minesweeper1
+//
+
+#include <climits>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Save.h"
+
+// The header is written a byte at a time in little-endian order, like the
+// replay archives.
+static void writeUint(uint8_t *out, uint64_t value, int nBytes)
+{
+    for (int byteIndex = 0; byteIndex < nBytes; byteIndex++)
+    {
+        out[byteIndex] = (uint8_t)(value >> (byteIndex * 8));
+    }
+}
+
+static uint64_t readUint(const uint8_t *in, int nBytes)
+{
+    uint64_t value = 0;
+
+    for (int byteIndex = 0; byteIndex < nBytes; byteIndex++)
+    {
+        value |= (uint64_t)in[byteIndex] << (byteIndex * 8);
+    }
+
+    return value;
+}
+
+// The planes go to disk as the words are in memory, which is already
+// little-endian on anything this runs on.  Anywhere else they are swapped
+// a word at a time.
+static bool isLittleEndianHost()
+{
+    uint16_t value = 1;
+    uint8_t firstByte;
+    memcpy(&firstByte, &value, 1);
+    return firstByte == 1;
+}
+
+static bool writePlane(const BitPlane &plane, FILE *file)
+{
+    if (isLittleEndianHost())
+    {
+        return fwrite(plane.data(), sizeof(uint64_t), plane.size(), file) == plane.size();
+    }
+
+    BitPlane swapped(plane);
+
+    for (int wordIndex = 0;
+         wordIndex < swapped.size();
+         wordIndex++)
+    {
+        swapped[wordIndex] = __builtin_bswap64(swapped[wordIndex]);
+    }
+
+    return fwrite(swapped.data(), sizeof(uint64_t), swapped.size(), file) == swapped.size();
+}
+
+// Bits past the last cell are cleared, the bit counts rely on it.
+static void readPlane(BitPlane &plane, const uint8_t *in, int nWords, int nCells)
+{
+    plane.resize(nWords);
+    memcpy(plane.data(), in, (size_t)nWords * sizeof(uint64_t));
+
+    if (!isLittleEndianHost())
+    {
+        for (int wordIndex = 0; wordIndex < nWords; wordIndex++)
+        {
+            plane[wordIndex] = __builtin_bswap64(plane[wordIndex]);
+        }
+    }
+
+    if (nCells % BITPLANE_WORD_BITS != 0)
+    {
+        plane[nWords - 1] &= ((uint64_t)1 << (nCells % BITPLANE_WORD_BITS)) - 1;
+    }
+}
+
+// A word at a time.  The game is still being played, so nothing open can
+// be a mine or flagged, and nothing is open before the mines go down.  The
+// mines have to come to what was saved.
+static bool planesAddUp(const Board &board, bool minesPlaced, int64_t nPlacedMines)
+{
+    int64_t nMines = 0;
+    uint64_t openMisplaced = 0;
+
+    for (int wordIndex = 0;
+         wordIndex < board.mines.size();
+         wordIndex++)
+    {
+        uint64_t open = board.open[wordIndex];
+        nMines += __builtin_popcountll(board.mines[wordIndex]);
+        openMisplaced |= open & (board.mines[wordIndex] | board.flags[wordIndex] | (minesPlaced ? 0 : ~0ULL));
+    }
+
+    return openMisplaced == 0 && nMines == (minesPlaced ? nPlacedMines : 0);
+}
+
+bool saveGame(const Game &game, const SaveExtras &extras, const char *path)
+{
+    if (game.status != GameStatus_Playing)
+    {
+        return false;
+    }
+
+    const Board &board = game.board;
+    uint16_t flags = (game.minesPlaced ? SAVE_FLAG_MINES_PLACED : 0) |
+                     (game.clearStartBlockOnReveal ? SAVE_FLAG_CLEAR_START_BLOCK : 0) |
+                     (extras.noGuess ? SAVE_FLAG_NO_GUESS : 0);
+    uint8_t header[SAVE_HEADER_SIZE] = { 0 };
+
+    writeUint(header, SAVE_MAGIC, 4);
+    writeUint(header + 4, SAVE_VERSION, 2);
+    writeUint(header + 6, flags, 2);
+    writeUint(header + 8, game.seed, 8);
+    writeUint(header + 16, (uint32_t)board.width, 4);
+    writeUint(header + 20, (uint32_t)board.height, 4);
+    writeUint(header + 24, (uint32_t)game.difficulty.nMines, 4);
+    writeUint(header + 28, (uint32_t)extras.mouseMode, 4);
+    writeUint(header + 32, extras.updates, 8);
+    writeUint(header + 40, (uint32_t)board.mines.size(), 4);
+    writeUint(header + 44, (uint32_t)(game.minesPlaced ? game.nMines : 0), 4);
+
+    std::string tempPath = std::string(path) + ".tmp";
+    FILE *file = fopen(tempPath.c_str(), "wb");
+
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    bool written = fwrite(header, 1, SAVE_HEADER_SIZE, file) == SAVE_HEADER_SIZE &&
+                   writePlane(board.mines, file) &&
+                   writePlane(board.open, file) &&
+                   writePlane(board.flags, file);
+
+    if (fclose(file) != 0 || !written || rename(tempPath.c_str(), path) != 0)
+    {
+        remove(tempPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool loadGame(Game &game, SaveExtras &extras, const char *path)
+{
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) < 0 || info.st_size < SAVE_HEADER_SIZE)
+    {
+        close(fd);
+        return false;
+    }
+
+    size_t size = (size_t)info.st_size;
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+
+    // Each plane is read front to back exactly once.
+    madvise(mapping, size, MADV_SEQUENTIAL);
+
+    const uint8_t *data = (const uint8_t *)mapping;
+    uint16_t flags = (uint16_t)readUint(data + 6, 2);
+    int64_t width = (int64_t)readUint(data + 16, 4);
+    int64_t height = (int64_t)readUint(data + 20, 4);
+    int64_t nMines = (int64_t)readUint(data + 24, 4);
+    int64_t nWords = (int64_t)readUint(data + 40, 4);
+    int64_t nPlacedMines = (int64_t)readUint(data + 44, 4);
+    int64_t nCells = width * height;
+
+    if (readUint(data, 4) != SAVE_MAGIC ||
+        readUint(data + 4, 2) != SAVE_VERSION ||
+        width < 1 || height < 1 || nCells > INT_MAX || nMines > INT_MAX ||
+        nWords != getBitPlaneWordCount((int)nCells) ||
+        size != SAVE_HEADER_SIZE + 3 * (size_t)nWords * sizeof(uint64_t))
+    {
+        munmap(mapping, size);
+        return false;
+    }
+
+    Board &board = game.board;
+    const uint8_t *planes = data + SAVE_HEADER_SIZE;
+    size_t planeBytes = (size_t)nWords * sizeof(uint64_t);
+
+    board.width = (int)width;
+    board.height = (int)height;
+    board.nCells = (int)nCells;
+    readPlane(board.mines, planes, (int)nWords, board.nCells);
+    readPlane(board.open, planes + planeBytes, (int)nWords, board.nCells);
+    readPlane(board.flags, planes + 2 * planeBytes, (int)nWords, board.nCells);
+
+    game.difficulty = { (int)height, (int)width, (int)nMines };
+    game.seed = readUint(data + 8, 8);
+    extras.mouseMode = (int)readUint(data + 28, 4);
+    extras.updates = readUint(data + 32, 8);
+    extras.noGuess = (flags & SAVE_FLAG_NO_GUESS) != 0;
+
+    munmap(mapping, size);
+
+    game.minesPlaced = (flags & SAVE_FLAG_MINES_PLACED) != 0;
+
+    if (!planesAddUp(board, game.minesPlaced, nPlacedMines))
+    {
+        return false;
+    }
+
+    board.adjacentMines.resize(board.nCells);
+    computeAdjacentMineCounts(board);
+
+    game.status = GameStatus_Playing;
+    game.clearStartBlockOnReveal = (flags & SAVE_FLAG_CLEAR_START_BLOCK) != 0;
+    recountGame(game);
+
+    return true;
+}
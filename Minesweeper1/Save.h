@@ -0,0 +1,49 @@
+//
+//  Save.h
+//  Minesweeper1
+//
+
+#ifndef Save_h
+#define Save_h
+
+#include <stdint.h>
+
+#include "Game.h"
+
+// A game in progress on disk, for picking it up again after quitting.
+//
+// A fixed little-endian header, then the mine, open and flag bitplanes one
+// after the other exactly as Board keeps them: one bit a cell, 64-bit
+// words, every plane starting on an 8-byte boundary.  That's 3 bits a
+// cell, about 3.6 MB for 10M cells.  Loading maps the file and copies each
+// plane into the board in one go; nothing is parsed per cell.  The
+// adjacency counts and the counters are worked out again from the planes
+// instead of being stored, and the mine list waits until the game needs it.
+
+static const uint32_t SAVE_MAGIC = 0x5653534d;  // "MSSV"
+static const uint16_t SAVE_VERSION = 2;
+static const int SAVE_HEADER_SIZE = 64;
+static const uint16_t SAVE_FLAG_MINES_PLACED = 1;
+static const uint16_t SAVE_FLAG_CLEAR_START_BLOCK = 2;
+static const uint16_t SAVE_FLAG_NO_GUESS = 4;
+
+// What the front end keeps about a game on top of the Game itself.  The
+// engine only carries it.
+typedef struct
+{
+    // The clock, in updates.
+    uint64_t updates;
+    int mouseMode;
+    bool noGuess;
+} SaveExtras;
+
+// Only games still being played make sense to save.  Written next to path
+// and renamed over it, so a failed save leaves the old one alone.
+bool saveGame(const Game &game, const SaveExtras &extras, const char *path);
+// Leaves game as it was saved, reusing the board's memory.  False if the
+// file is missing, from another version or doesn't add up (a mine or flag
+// open, or a mine count that doesn't match the plane), in which case game
+// may have been cleared.
+bool loadGame(Game &game, SaveExtras &extras, const char *path);
+
+#endif /* Save_h */
@@ -0,0 +1,410 @@
+//
+//  Solver.cpp
+//  Minesweeper1
+//
+
+#include <algorithm>
+
+#include "Solver.h"
+
+typedef struct
+{
+    int unknownCells[8];
+    int nUnknown;
+    int nMinesLeft;
+} Constraint;
+
+static void readConstraint(const Solver &solver, const Board &board, int cellIndex, Constraint &constraint)
+{
+    int cellX = getCellX(board, cellIndex);
+    int cellY = getCellY(board, cellIndex);
+    int minX = std::max(cellX - 1, 0);
+    int maxX = std::min(cellX + 1, board.width - 1);
+    int minY = std::max(cellY - 1, 0);
+    int maxY = std::min(cellY + 1, board.height - 1);
+
+    constraint.nUnknown = 0;
+    constraint.nMinesLeft = getAdjacentMines(board, cellIndex);
+
+    for (int y = minY; y <= maxY; y++)
+    {
+        for (int x = minX; x <= maxX; x++)
+        {
+            int neighbourIndex = getCellIndex(board, x, y);
+
+            if (neighbourIndex == cellIndex || cellIsOpen(board, neighbourIndex))
+            {
+                continue;
+            }
+
+            if (isKnownMine(solver, neighbourIndex))
+            {
+                constraint.nMinesLeft--;
+            }
+            else if (!isKnownSafe(solver, neighbourIndex))
+            {
+                constraint.unknownCells[constraint.nUnknown++] = neighbourIndex;
+            }
+        }
+    }
+}
+
+static void enqueueConstraint(Solver &solver, int cellIndex)
+{
+    if (!getBit(solver.isConstraint, cellIndex))
+    {
+        return;
+    }
+
+    if (!getBit(solver.inWorklist, cellIndex))
+    {
+        setBit(solver.inWorklist, cellIndex);
+        solver.worklist.push_back(cellIndex);
+    }
+
+    if (!getBit(solver.inPairWorklist, cellIndex))
+    {
+        setBit(solver.inPairWorklist, cellIndex);
+        solver.pairWorklist.push_back(cellIndex);
+    }
+}
+
+// Something about cellIndex changed, so every constraint touching it has to
+// be looked at again.
+static void enqueueNeighbourConstraints(Solver &solver, const Board &board, int cellIndex)
+{
+    int cellX = getCellX(board, cellIndex);
+    int cellY = getCellY(board, cellIndex);
+    int minX = std::max(cellX - 1, 0);
+    int maxX = std::min(cellX + 1, board.width - 1);
+    int minY = std::max(cellY - 1, 0);
+    int maxY = std::min(cellY + 1, board.height - 1);
+
+    for (int y = minY; y <= maxY; y++)
+    {
+        for (int x = minX; x <= maxX; x++)
+        {
+            enqueueConstraint(solver, getCellIndex(board, x, y));
+        }
+    }
+}
+
+static void markMine(Solver &solver, const Board &board, int cellIndex)
+{
+    setBit(solver.knownMines, cellIndex);
+    solver.nKnownMines++;
+    enqueueNeighbourConstraints(solver, board, cellIndex);
+}
+
+static void markSafe(Solver &solver, const Board &board, int cellIndex)
+{
+    setBit(solver.knownSafe, cellIndex);
+    solver.safeCells.push_back(cellIndex);
+    enqueueNeighbourConstraints(solver, board, cellIndex);
+}
+
+static int applySingleCellRules(Solver &solver, const Board &board, int cellIndex)
+{
+    Constraint constraint;
+    readConstraint(solver, board, cellIndex, constraint);
+
+    if (constraint.nUnknown == 0)
+    {
+        clearBit(solver.isConstraint, cellIndex);
+        return 0;
+    }
+
+    if (constraint.nMinesLeft == 0)
+    {
+        for (int unknownIndex = 0; unknownIndex < constraint.nUnknown; unknownIndex++)
+        {
+            markSafe(solver, board, constraint.unknownCells[unknownIndex]);
+        }
+
+        clearBit(solver.isConstraint, cellIndex);
+        return constraint.nUnknown;
+    }
+
+    if (constraint.nMinesLeft == constraint.nUnknown)
+    {
+        for (int unknownIndex = 0; unknownIndex < constraint.nUnknown; unknownIndex++)
+        {
+            markMine(solver, board, constraint.unknownCells[unknownIndex]);
+        }
+
+        clearBit(solver.isConstraint, cellIndex);
+        return constraint.nUnknown;
+    }
+
+    return 0;
+}
+
+// Cells of a that aren't in b.
+static int subtractCells(const Constraint &a, const Constraint &b, int *out)
+{
+    int nOut = 0;
+
+    for (int aIndex = 0; aIndex < a.nUnknown; aIndex++)
+    {
+        bool shared = false;
+
+        for (int bIndex = 0; bIndex < b.nUnknown; bIndex++)
+        {
+            if (a.unknownCells[aIndex] == b.unknownCells[bIndex])
+            {
+                shared = true;
+                break;
+            }
+        }
+
+        if (!shared)
+        {
+            out[nOut++] = a.unknownCells[aIndex];
+        }
+    }
+
+    return nOut;
+}
+
+// For overlapping constraints A and B: if B needs exactly as many more
+// mines than A as it has cells A doesn't, then all of those are mines and
+// A's cells outside B are all safe.  If B's extra cells need no mines at
+// all while A's cells all sit inside B, they are safe.
+static int applyPairRules(Solver &solver, const Board &board, int cellIndex)
+{
+    Constraint a;
+    readConstraint(solver, board, cellIndex, a);
+
+    if (a.nUnknown == 0)
+    {
+        return 0;
+    }
+
+    int cellX = getCellX(board, cellIndex);
+    int cellY = getCellY(board, cellIndex);
+    int minX = std::max(cellX - 2, 0);
+    int maxX = std::min(cellX + 2, board.width - 1);
+    int minY = std::max(cellY - 2, 0);
+    int maxY = std::min(cellY + 2, board.height - 1);
+
+    for (int y = minY; y <= maxY; y++)
+    {
+        for (int x = minX; x <= maxX; x++)
+        {
+            int otherIndex = getCellIndex(board, x, y);
+
+            if (otherIndex == cellIndex || !getBit(solver.isConstraint, otherIndex))
+            {
+                continue;
+            }
+
+            Constraint b;
+            readConstraint(solver, board, otherIndex, b);
+
+            int onlyA[8];
+            int onlyB[8];
+            int nOnlyA = subtractCells(a, b, onlyA);
+            int nOnlyB = subtractCells(b, a, onlyB);
+
+            if (nOnlyA == a.nUnknown)
+            {
+                // No overlap, nothing to learn.
+                continue;
+            }
+
+            int nDeduced = 0;
+            int mineDifference = b.nMinesLeft - a.nMinesLeft;
+
+            if (nOnlyB > 0 && mineDifference == nOnlyB)
+            {
+                for (int onlyIndex = 0; onlyIndex < nOnlyB; onlyIndex++)
+                {
+                    markMine(solver, board, onlyB[onlyIndex]);
+                }
+
+                for (int onlyIndex = 0; onlyIndex < nOnlyA; onlyIndex++)
+                {
+                    markSafe(solver, board, onlyA[onlyIndex]);
+                }
+
+                nDeduced = nOnlyA + nOnlyB;
+            }
+            else if (nOnlyA > 0 && -mineDifference == nOnlyA)
+            {
+                for (int onlyIndex = 0; onlyIndex < nOnlyA; onlyIndex++)
+                {
+                    markMine(solver, board, onlyA[onlyIndex]);
+                }
+
+                for (int onlyIndex = 0; onlyIndex < nOnlyB; onlyIndex++)
+                {
+                    markSafe(solver, board, onlyB[onlyIndex]);
+                }
+
+                nDeduced = nOnlyA + nOnlyB;
+            }
+            else if (nOnlyA == 0 && nOnlyB > 0 && mineDifference == 0)
+            {
+                for (int onlyIndex = 0; onlyIndex < nOnlyB; onlyIndex++)
+                {
+                    markSafe(solver, board, onlyB[onlyIndex]);
+                }
+
+                nDeduced = nOnlyB;
+            }
+
+            if (nDeduced > 0)
+            {
+                // A has changed, it is back on the worklists already.
+                return nDeduced;
+            }
+        }
+    }
+
+    return 0;
+}
+
+void initSolver(Solver &solver, const Board &board)
+{
+    solver.width = board.width;
+    solver.height = board.height;
+    resetBitPlane(solver.knownMines, board.nCells);
+    resetBitPlane(solver.knownSafe, board.nCells);
+    resetBitPlane(solver.isConstraint, board.nCells);
+    resetBitPlane(solver.inWorklist, board.nCells);
+    resetBitPlane(solver.inPairWorklist, board.nCells);
+    solver.worklist.clear();
+    solver.pairWorklist.clear();
+    solver.constraints.clear();
+    solver.safeCells.clear();
+    solver.nKnownMines = 0;
+
+    std::vector<int> openCells;
+
+    // A word at a time, so a fresh board costs next to nothing.
+    for (int wordIndex = 0;
+         wordIndex < board.open.size();
+         wordIndex++)
+    {
+        uint64_t open = board.open[wordIndex];
+
+        while (open != 0)
+        {
+            openCells.push_back(wordIndex * BITPLANE_WORD_BITS + __builtin_ctzll(open));
+            open &= open - 1;
+        }
+    }
+
+    updateSolver(solver, board, openCells);
+}
+
+void updateSolver(Solver &solver, const Board &board, const std::vector<int> &changedCells)
+{
+    for (int changedIndex = 0;
+         changedIndex < changedCells.size();
+         changedIndex++)
+    {
+        int cellIndex = changedCells[changedIndex];
+
+        // Flags are the player's opinion, the solver keeps its own.
+        if (!cellIsOpen(board, cellIndex) || cellHasMine(board, cellIndex))
+        {
+            continue;
+        }
+
+        if (getAdjacentMines(board, cellIndex) > 0 &&
+            !getBit(solver.isConstraint, cellIndex))
+        {
+            setBit(solver.isConstraint, cellIndex);
+            solver.constraints.push_back(cellIndex);
+        }
+
+        enqueueNeighbourConstraints(solver, board, cellIndex);
+    }
+}
+
+int solve(Solver &solver, const Board &board)
+{
+    int nDeduced = 0;
+
+    while (true)
+    {
+        while (!solver.worklist.empty())
+        {
+            int cellIndex = solver.worklist.back();
+            solver.worklist.pop_back();
+            clearBit(solver.inWorklist, cellIndex);
+
+            if (getBit(solver.isConstraint, cellIndex))
+            {
+                nDeduced += applySingleCellRules(solver, board, cellIndex);
+            }
+        }
+
+        // The pair rules are only worth it once the cheap rules are stuck.
+        if (solver.pairWorklist.empty())
+        {
+            break;
+        }
+
+        int cellIndex = solver.pairWorklist.back();
+        solver.pairWorklist.pop_back();
+        clearBit(solver.inPairWorklist, cellIndex);
+
+        if (getBit(solver.isConstraint, cellIndex))
+        {
+            nDeduced += applyPairRules(solver, board, cellIndex);
+        }
+    }
+
+    return nDeduced;
+}
+
+int getNextSafeCell(Solver &solver, const Board &board)
+{
+    while (!solver.safeCells.empty())
+    {
+        int cellIndex = solver.safeCells.back();
+
+        if (!cellIsOpen(board, cellIndex))
+        {
+            return cellIndex;
+        }
+
+        solver.safeCells.pop_back();
+    }
+
+    return -1;
+}
+
+const std::vector<int> &getFrontierConstraints(Solver &solver, const Board &board)
+{
+    int nKept = 0;
+
+    for (int constraintIndex = 0;
+         constraintIndex < solver.constraints.size();
+         constraintIndex++)
+    {
+        int cellIndex = solver.constraints[constraintIndex];
+
+        if (!getBit(solver.isConstraint, cellIndex))
+        {
+            continue;
+        }
+
+        Constraint constraint;
+        readConstraint(solver, board, cellIndex, constraint);
+
+        if (constraint.nUnknown == 0)
+        {
+            clearBit(solver.isConstraint, cellIndex);
+            continue;
+        }
+
+        solver.constraints[nKept++] = cellIndex;
+    }
+
+    solver.constraints.resize(nKept);
+
+    return solver.constraints;
+}
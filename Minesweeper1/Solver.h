@@ -0,0 +1,71 @@
+//
+//  Solver.h
+//  Minesweeper1
+//
+
+#ifndef Solver_h
+#define Solver_h
+
+#include <vector>
+
+#include "Board.h"
+
+// Works out which closed cells are certainly safe or certainly mines from
+// what the player can see: which cells are open and the numbers on them.
+// It never looks at the mine bitplane.
+//
+// Every open numbered cell is a constraint: the closed cells around it
+// that aren't known yet hold exactly (number - known mines around it)
+// mines.  Constraints that still touch unknown cells are the frontier.
+// Opening cells only touches the constraints around them, so the solver is
+// fed the cells a command changed and only looks at what they affect.
+typedef struct
+{
+    int width = 0;
+    int height = 0;
+    BitPlane knownMines;
+    BitPlane knownSafe;
+    BitPlane isConstraint;
+    // Constraints to run the single cell rules on / the pair rules on.
+    BitPlane inWorklist;
+    BitPlane inPairWorklist;
+    std::vector<int> worklist;
+    std::vector<int> pairWorklist;
+    // Frontier constraints.  Resolved ones are only dropped when the list
+    // is asked for, isConstraint is the authority.
+    std::vector<int> constraints;
+    // Deduced safe cells that were still closed when they were found.
+    std::vector<int> safeCells;
+    int nKnownMines = 0;
+} Solver;
+
+// Forgets everything and starts from whatever is already open on the board.
+void initSolver(Solver &solver, const Board &board);
+// Tells the solver which cells changed, e.g. GameDelta::changedCells.
+void updateSolver(Solver &solver, const Board &board, const std::vector<int> &changedCells);
+// Runs the single cell rules, then the pair rules between overlapping
+// constraints, until nothing new comes out.  Returns how many cells it
+// learned about.
+int solve(Solver &solver, const Board &board);
+// A deduced safe cell that is still closed, or -1.  Doesn't consume it;
+// opening the cell does.
+int getNextSafeCell(Solver &solver, const Board &board);
+inline bool isKnownMine(const Solver &solver, int cellIndex)
+{
+    return getBit(solver.knownMines, cellIndex);
+}
+inline bool isKnownSafe(const Solver &solver, int cellIndex)
+{
+    return getBit(solver.knownSafe, cellIndex);
+}
+// Closed and neither a known mine nor known safe.
+inline bool isUnknownCell(const Solver &solver, const Board &board, int cellIndex)
+{
+    return !cellIsOpen(board, cellIndex) &&
+           !getBit(solver.knownMines, cellIndex) &&
+           !getBit(solver.knownSafe, cellIndex);
+}
+// The constraints that still touch unknown cells.
+const std::vector<int> &getFrontierConstraints(Solver &solver, const Board &board);
+
+#endif /* Solver_h */
@@ -0,0 +1,190 @@
+//
+//  TextAtlas.cpp
+//  Minesweeper1
+//
+
+#include <iostream>
+#include <algorithm>
+
+#include "Profile.h"
+#include "TextAtlas.h"
+
+static void textAtlasFatal(const char *message)
+{
+    std::cout << message << std::endl;
+    std::cout << SDL_GetError() << std::endl;
+    SDL_Quit();
+    TTF_Quit();
+    exit(1);
+}
+
+static Uint32 packColor(SDL_Color color)
+{
+    return ((Uint32)color.r << 24) | ((Uint32)color.g << 16) |
+           ((Uint32)color.b << 8) | (Uint32)color.a;
+}
+
+static TextAtlasPage &addTextAtlasPage(TextAtlas &atlas, int minWidth, int minHeight)
+{
+    // Strings that don't fit on a regular page get a page of their own.
+    int width = std::max(TEXT_ATLAS_PAGE_WIDTH, minWidth);
+    int height = std::max(TEXT_ATLAS_PAGE_HEIGHT, minHeight);
+
+    PROFILE_COUNT("textures created", 1);
+    SDL_Texture *texture = SDL_CreateTexture(atlas.renderer,
+                                             SDL_PIXELFORMAT_ARGB8888,
+                                             SDL_TEXTUREACCESS_STATIC,
+                                             width,
+                                             height);
+
+    if (texture == nullptr)
+    {
+        textAtlasFatal("Unable to create text atlas page");
+    }
+
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    atlas.stats.texturesCreated++;
+    atlas.stats.pages++;
+
+    TextAtlasPage page = {
+        texture,
+        width,
+        height,
+        0,  // shelfX
+        0,  // shelfY
+        0   // shelfHeight
+    };
+
+    atlas.pages.push_back(page);
+
+    return atlas.pages.back();
+}
+
+// Finds room for a w*h rect, moving to a new shelf or page if needed.
+static SDL_Rect allocateTextAtlasRect(TextAtlas &atlas, int w, int h, SDL_Texture *&texture)
+{
+    int paddedW = w + TEXT_ATLAS_PADDING;
+    int paddedH = h + TEXT_ATLAS_PADDING;
+
+    if (atlas.pages.empty())
+    {
+        addTextAtlasPage(atlas, paddedW, paddedH);
+    }
+
+    TextAtlasPage *page = &atlas.pages.back();
+
+    // Too wide for this page even on a shelf of its own.
+    if (paddedW > page->width)
+    {
+        page = &addTextAtlasPage(atlas, paddedW, paddedH);
+    }
+
+    if (page->shelfX + paddedW > page->width)
+    {
+        page->shelfX = 0;
+        page->shelfY += page->shelfHeight;
+        page->shelfHeight = 0;
+    }
+
+    if (page->shelfY + paddedH > page->height)
+    {
+        page = &addTextAtlasPage(atlas, paddedW, paddedH);
+    }
+
+    SDL_Rect rect = {
+        page->shelfX,
+        page->shelfY,
+        w,
+        h
+    };
+
+    page->shelfX += paddedW;
+    page->shelfHeight = std::max(page->shelfHeight, paddedH);
+    texture = page->texture;
+
+    return rect;
+}
+
+void initTextAtlas(TextAtlas &atlas, SDL_Renderer *renderer)
+{
+    quitTextAtlas(atlas);
+    atlas.renderer = renderer;
+    atlas.stats = { 0, 0, 0, 0 };
+}
+
+void quitTextAtlas(TextAtlas &atlas)
+{
+    for (int pageIndex = 0;
+         pageIndex < atlas.pages.size();
+         pageIndex++)
+    {
+        SDL_DestroyTexture(atlas.pages[pageIndex].texture);
+    }
+
+    atlas.pages.clear();
+    atlas.entries.clear();
+    atlas.renderer = nullptr;
+}
+
+const TextAtlasEntry &getTextAtlasEntry(TextAtlas &atlas,
+                                        TTF_Font *font,
+                                        const char *text,
+                                        SDL_Color color)
+{
+    TextAtlasKey key = {
+        font,
+        text,
+        packColor(color)
+    };
+
+    auto found = atlas.entries.find(key);
+
+    if (found != atlas.entries.end())
+    {
+        atlas.stats.hits++;
+        return found->second;
+    }
+
+    atlas.stats.misses++;
+
+    SDL_Surface *fontSurface = TTF_RenderText_Blended(font, text, color);
+
+    if (fontSurface == nullptr)
+    {
+        std::cout << "Unable to render font" << std::endl;
+        std::cout << TTF_GetError() << std::endl;
+        SDL_Quit();
+        TTF_Quit();
+        exit(1);
+    }
+
+    // The atlas pages are ARGB8888, so the pixels can go straight into
+    // SDL_UpdateTexture once the surface matches.
+    SDL_Surface *argbSurface = SDL_ConvertSurfaceFormat(fontSurface,
+                                                        SDL_PIXELFORMAT_ARGB8888,
+                                                        0);
+    SDL_FreeSurface(fontSurface);
+
+    if (argbSurface == nullptr)
+    {
+        textAtlasFatal("Unable to convert font surface");
+    }
+
+    TextAtlasEntry entry;
+    entry.rect = allocateTextAtlasRect(atlas, argbSurface->w, argbSurface->h, entry.texture);
+
+    if (SDL_UpdateTexture(entry.texture, &entry.rect,
+                          argbSurface->pixels, argbSurface->pitch) < 0)
+    {
+        textAtlasFatal("Unable to upload text to atlas");
+    }
+
+    SDL_FreeSurface(argbSurface);
+
+    return atlas.entries.insert(std::make_pair(key, entry)).first->second;
+}
+
+TextAtlasStats getTextAtlasStats(const TextAtlas &atlas)
+{
+    return atlas.stats;
+}
@@ -0,0 +1,96 @@
+//
+//  TextAtlas.h
+//  Minesweeper1
+//
+
+#ifndef TextAtlas_h
+#define TextAtlas_h
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+// Every string that has ever been drawn is rasterized once and packed into a
+// big texture page.  Drawing it again is just an SDL_RenderCopy of a sub-rect.
+// The pages are textures on the renderer the atlas was made with, so it
+// can only be drawn with that one.
+
+static const int TEXT_ATLAS_PAGE_WIDTH = 512;
+static const int TEXT_ATLAS_PAGE_HEIGHT = 512;
+static const int TEXT_ATLAS_PADDING = 1;
+
+typedef struct
+{
+    uint64_t hits;
+    uint64_t misses;
+    int texturesCreated;
+    int pages;
+} TextAtlasStats;
+
+typedef struct
+{
+    SDL_Texture *texture;
+    SDL_Rect rect;
+} TextAtlasEntry;
+
+typedef struct
+{
+    SDL_Texture *texture;
+    int width;
+    int height;
+    // Shelf packing: entries go left to right, a new shelf starts below
+    // the tallest entry once a row fills up.
+    int shelfX;
+    int shelfY;
+    int shelfHeight;
+} TextAtlasPage;
+
+typedef struct
+{
+    TTF_Font *font;
+    std::string text;
+    Uint32 color;
+} TextAtlasKey;
+
+struct TextAtlasKeyHash
+{
+    size_t operator()(const TextAtlasKey &key) const
+    {
+        size_t hash = std::hash<std::string>()(key.text);
+        hash ^= std::hash<const void *>()(key.font) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        hash ^= std::hash<Uint32>()(key.color) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        return hash;
+    }
+};
+
+struct TextAtlasKeyEqual
+{
+    bool operator()(const TextAtlasKey &a, const TextAtlasKey &b) const
+    {
+        return a.font == b.font && a.color == b.color && a.text == b.text;
+    }
+};
+
+typedef struct
+{
+    SDL_Renderer *renderer = nullptr;
+    std::vector<TextAtlasPage> pages;
+    std::unordered_map<TextAtlasKey, TextAtlasEntry,
+                       TextAtlasKeyHash, TextAtlasKeyEqual> entries;
+    TextAtlasStats stats = { 0, 0, 0, 0 };
+} TextAtlas;
+
+void initTextAtlas(TextAtlas &atlas, SDL_Renderer *renderer);
+// Destroys every page.  Has to be called before the renderer goes away.
+void quitTextAtlas(TextAtlas &atlas);
+// Rasterizes and uploads the text on the first call, looks it up afterwards.
+const TextAtlasEntry &getTextAtlasEntry(TextAtlas &atlas,
+                                        TTF_Font *font,
+                                        const char *text,
+                                        SDL_Color color);
+TextAtlasStats getTextAtlasStats(const TextAtlas &atlas);
+
+#endif /* TextAtlas_h */
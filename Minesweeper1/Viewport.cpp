@@ -0,0 +1,67 @@
+//
+//  Viewport.cpp
+//  Minesweeper1
+//
+
+#include <algorithm>
+#include <cmath>
+
+#include "Viewport.h"
+
+static double clampViewportAxis(double position, int viewSize, int boardSize, double zoom)
+{
+    double visibleSize = viewSize / zoom;
+
+    if (boardSize <= visibleSize)
+    {
+        return -(visibleSize - boardSize) / 2.0;
+    }
+
+    return std::min(std::max(position, 0.0), boardSize - visibleSize);
+}
+
+static void clampViewport(Viewport &viewport)
+{
+    viewport.x = clampViewportAxis(viewport.x, viewport.width, viewport.boardWidth, viewport.zoom);
+    viewport.y = clampViewportAxis(viewport.y, viewport.height, viewport.boardHeight, viewport.zoom);
+}
+
+void initViewport(Viewport &viewport, int width, int height, int boardWidth, int boardHeight)
+{
+    viewport.x = 0.0;
+    viewport.y = 0.0;
+    viewport.zoom = 1.0;
+    viewport.width = width;
+    viewport.height = height;
+    viewport.boardWidth = boardWidth;
+    viewport.boardHeight = boardHeight;
+    clampViewport(viewport);
+}
+
+void panViewport(Viewport &viewport, double dx, double dy)
+{
+    viewport.x += dx / viewport.zoom;
+    viewport.y += dy / viewport.zoom;
+    clampViewport(viewport);
+}
+
+void zoomViewport(Viewport &viewport, double factor, double screenX, double screenY)
+{
+    double boardX = getBoardX(viewport, screenX);
+    double boardY = getBoardY(viewport, screenY);
+
+    viewport.zoom = std::min(std::max(viewport.zoom * factor, VIEWPORT_MIN_ZOOM), VIEWPORT_MAX_ZOOM);
+    viewport.x = boardX - screenX / viewport.zoom;
+    viewport.y = boardY - screenY / viewport.zoom;
+    clampViewport(viewport);
+}
+
+int getScreenX(const Viewport &viewport, double boardX)
+{
+    return (int)floor((boardX - viewport.x) * viewport.zoom);
+}
+
+int getScreenY(const Viewport &viewport, double boardY)
+{
+    return (int)floor((boardY - viewport.y) * viewport.zoom);
+}
@@ -0,0 +1,50 @@
+//
+//  Viewport.h
+//  Minesweeper1
+//
+
+#ifndef Viewport_h
+#define Viewport_h
+
+// The part of the board that's on screen.  Positions on the board are in
+// board pixels (CELL_WIDTH per cell, no zoom); the view is width x height
+// screen pixels showing the board from (x, y) at zoom screen pixels per
+// board pixel.  A board smaller than the view is centered in it.
+
+static const double VIEWPORT_MIN_ZOOM = 0.25;
+static const double VIEWPORT_MAX_ZOOM = 4.0;
+
+typedef struct
+{
+    double x;
+    double y;
+    double zoom;
+    int width;
+    int height;
+    int boardWidth;
+    int boardHeight;
+} Viewport;
+
+// Zoom 1, top left corner of the board in the top left of the view.
+void initViewport(Viewport &viewport, int width, int height, int boardWidth, int boardHeight);
+// dx and dy are in screen pixels.
+void panViewport(Viewport &viewport, double dx, double dy);
+// Multiplies the zoom by factor, within the limits, keeping the board point
+// under (screenX, screenY) where it is.
+void zoomViewport(Viewport &viewport, double factor, double screenX, double screenY);
+
+inline double getBoardX(const Viewport &viewport, double screenX)
+{
+    return viewport.x + screenX / viewport.zoom;
+}
+
+inline double getBoardY(const Viewport &viewport, double screenY)
+{
+    return viewport.y + screenY / viewport.zoom;
+}
+
+// Rounded down, so the edges of neighbouring rects always meet.
+int getScreenX(const Viewport &viewport, double boardX);
+int getScreenY(const Viewport &viewport, double boardY);
+
+#endif /* Viewport_h */
@@ -0,0 +1,198 @@
+//
+//  WorkPool.cpp
+//  Minesweeper1
+//
+
+#include <algorithm>
+
+#include "WorkPool.h"
+
+// Which queue belongs to the current thread, -1 off the pool.
+static thread_local int tWorkerIndex = -1;
+static thread_local WorkPool *tWorkerPool = nullptr;
+
+static bool popOwnWork(WorkQueue &queue, WorkTask &task)
+{
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.tasks.empty())
+    {
+        return false;
+    }
+
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+static bool stealWork(WorkQueue &queue, WorkTask &task)
+{
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.tasks.empty())
+    {
+        return false;
+    }
+
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    return true;
+}
+
+// Own queue first, then everyone else's starting with the next one over.
+static bool findWork(WorkPool &pool, int workerIndex, WorkTask &task)
+{
+    int nQueues = (int)pool.queues.size();
+
+    if (workerIndex >= 0 && popOwnWork(*pool.queues[workerIndex], task))
+    {
+        pool.nQueued--;
+        return true;
+    }
+
+    int start = workerIndex >= 0 ? workerIndex + 1 : 0;
+
+    for (int offset = 0; offset < nQueues; offset++)
+    {
+        int queueIndex = (start + offset) % nQueues;
+
+        if (queueIndex != workerIndex && stealWork(*pool.queues[queueIndex], task))
+        {
+            pool.nQueued--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void runWorkTask(WorkTask &task)
+{
+    task.item();
+    task.group->nPending--;
+}
+
+static void runWorker(WorkPool *pool, int workerIndex)
+{
+    tWorkerIndex = workerIndex;
+    tWorkerPool = pool;
+
+    while (true)
+    {
+        WorkTask task;
+
+        if (findWork(*pool, workerIndex, task))
+        {
+            runWorkTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(pool->wakeMutex);
+        pool->wakeCondition.wait(lock, [pool]() {
+            return pool->stopping || pool->nQueued > 0;
+        });
+
+        if (pool->stopping)
+        {
+            return;
+        }
+    }
+}
+
+void startWorkPool(WorkPool &pool, int nThreads)
+{
+    if (nThreads <= 0)
+    {
+        nThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+
+    pool.stopping = false;
+    pool.nQueued = 0;
+    pool.nextQueue = 0;
+    pool.queues.clear();
+
+    for (int threadIndex = 0; threadIndex < nThreads; threadIndex++)
+    {
+        pool.queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+    }
+
+    for (int threadIndex = 0; threadIndex < nThreads; threadIndex++)
+    {
+        pool.threads.push_back(std::thread(runWorker, &pool, threadIndex));
+    }
+}
+
+void stopWorkPool(WorkPool &pool)
+{
+    {
+        std::lock_guard<std::mutex> lock(pool.wakeMutex);
+        pool.stopping = true;
+    }
+
+    pool.wakeCondition.notify_all();
+
+    for (int threadIndex = 0;
+         threadIndex < pool.threads.size();
+         threadIndex++)
+    {
+        pool.threads[threadIndex].join();
+    }
+
+    pool.threads.clear();
+    pool.queues.clear();
+}
+
+int getWorkPoolThreadCount(const WorkPool &pool)
+{
+    return (int)pool.threads.size();
+}
+
+void initWorkGroup(WorkGroup &group)
+{
+    group.nPending = 0;
+}
+
+void submitWork(WorkPool &pool, WorkGroup &group, WorkItem item)
+{
+    // Work submitted from a worker stays on its own deque so it runs while
+    // the data is still in that core's cache; everyone else deals round
+    // robin.
+    int queueIndex = tWorkerPool == &pool
+        ? tWorkerIndex
+        : (int)(pool.nextQueue++ % pool.queues.size());
+
+    group.nPending++;
+
+    {
+        std::lock_guard<std::mutex> lock(pool.queues[queueIndex]->mutex);
+        WorkTask task = { std::move(item), &group };
+        pool.queues[queueIndex]->tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pool.wakeMutex);
+        pool.nQueued++;
+    }
+
+    pool.wakeCondition.notify_one();
+}
+
+void waitForWorkGroup(WorkPool &pool, WorkGroup &group)
+{
+    int workerIndex = tWorkerPool == &pool ? tWorkerIndex : -1;
+
+    while (group.nPending > 0)
+    {
+        WorkTask task;
+
+        if (findWork(pool, workerIndex, task))
+        {
+            runWorkTask(task);
+        }
+        else
+        {
+            // Whatever is left is already running on other threads.
+            std::this_thread::yield();
+        }
+    }
+}
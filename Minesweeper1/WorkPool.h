@@ -0,0 +1,65 @@
+//
+//  WorkPool.h
+//  Minesweeper1
+//
+
+#ifndef WorkPool_h
+#define WorkPool_h
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads, each with its own deque.  Workers take
+// their newest work from the back of their own deque and steal the oldest
+// work from the front of someone else's when theirs runs dry.
+
+typedef std::function<void()> WorkItem;
+
+// Counts the work submitted under it that hasn't finished yet.  Waiting on
+// a group instead of on the whole pool lets work submit and wait for more
+// work without deadlocking.
+typedef struct
+{
+    std::atomic<int> nPending;
+} WorkGroup;
+
+typedef struct
+{
+    WorkItem item;
+    WorkGroup *group;
+} WorkTask;
+
+typedef struct
+{
+    std::mutex mutex;
+    std::deque<WorkTask> tasks;
+} WorkQueue;
+
+typedef struct
+{
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    std::atomic<int> nQueued;
+    std::atomic<unsigned> nextQueue;
+    bool stopping;
+} WorkPool;
+
+// nThreads <= 0 means one per core.
+void startWorkPool(WorkPool &pool, int nThreads);
+void stopWorkPool(WorkPool &pool);
+int getWorkPoolThreadCount(const WorkPool &pool);
+void initWorkGroup(WorkGroup &group);
+void submitWork(WorkPool &pool, WorkGroup &group, WorkItem item);
+// Runs queued work on the calling thread until everything in the group
+// has finished.
+void waitForWorkGroup(WorkPool &pool, WorkGroup &group);
+
+#endif /* WorkPool_h */
@@ -7,27 +7,48 @@
 //
 
 #include <iostream>
-#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
 #include <functional>
 #include <vector>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 
+#include "Board.h"
+#include "BoardPool.h"
+#include "Game.h"
+#include "Generator.h"
+#include "Input.h"
+#include "Probability.h"
+#include "Profile.h"
+#include "Random.h"
+#include "Replay.h"
+#include "Save.h"
+#include "Solver.h"
+#include "TextAtlas.h"
+#include "Viewport.h"
+#include "WorkPool.h"
 #include "main.h"
 
 static GameState gState;
 static bool gRunning = false;
 static Difficulty gDifficulty;
+// The launcher's Custom button, --custom COLS ROWS MINES sets it.
+static Difficulty gCustomDifficulty = { 1024, 1024, 102400 };
+
+// One window and renderer for the whole run.  The launcher and the game
+// are scenes in it; switching scenes resizes the window, and every
+// texture either of them made stays around for next time.
+static SDL_Window *gWindow = nullptr;
+static SDL_Renderer *gRenderer = nullptr;
 
 // Launcher View
-static SDL_Window *gLauncherWindow = nullptr;
-static SDL_Renderer *gLauncherRenderer = nullptr;
 static std::vector<Button> launcherButtons;
 
 // Game View
 static Vector2i gameWindowSize;
-static SDL_Window *gGameWindow = nullptr;
-static SDL_Renderer *gGameRenderer = nullptr;
 static std::vector<Button> gameButtons;
 // Maybe I should call this field something else.
 // It definitely belongs in Game, though
@@ -37,7 +58,48 @@ static MouseMode gMouseMode;
 static SDL_Renderer *gCurrentRenderer = nullptr;
 
 // View
-static std::vector<Cell> gameCells;
+// All the rules live in gGame, this file only turns mouse input into
+// commands and draws what changed.
+static Game gGame;
+static GameDelta gGameDelta;
+// Kept up to date with every command so H can ask it for a safe cell.
+static Solver gSolver;
+static int gHintCellIndex = -1;
+// P shades every closed cell by how likely it is to be a mine.  The
+// components are enumerated on gWorkPool.
+static bool gShowProbabilities = false;
+static ProbabilityMap gProbabilityMap;
+static WorkPool gWorkPool;
+// Boards are cleared on the pool's thread between games, see initGame.
+static BoardPool gBoardPool;
+// The board is cut into CHUNK_CELLS x CHUNK_CELLS chunks.  A chunk on
+// screen is kept in its own texture and only the cells that changed since
+// the last frame get redrawn into it; chunks off screen don't get a
+// texture, or lose it once the cache is over budget.  A frame costs the
+// same however big the board is.
+static Viewport gViewport;
+static std::vector<BoardChunk> gChunks;
+static int gChunkCols = 0;
+static int gChunkRows = 0;
+static std::vector<int> gChunksWithTextures;
+// The board size the chunks were laid out for.  A new game on a board the
+// same size keeps the textures and just redraws them.
+static Vector2i gChunkedBoardSize = { 0, 0 };
+static size_t gChunkTextureBytes = 0;
+// Chunk textures are drawn at min(zoom, 1) so zooming out doesn't need
+// textures any bigger than the view.
+static double gChunkScale = 1.0;
+static bool gChunkTexturesSupported = true;
+static Uint64 gRenderFrame = 0;
+static CellTransform gCellTransform = { 0, 0, CELL_WIDTH, CELL_HEIGHT };
+static std::vector<int> gDirtyCells;
+static std::vector<bool> gCellIsDirty;
+static int gHoveredCellIndex = -1;
+static MouseMode gHoveredMouseMode;
+// Cells sorted into per-color rect arrays so each color is one draw call.
+// B toggles it to compare against drawing cell by cell.
+static bool gBatchedRendering = true;
+static CellBatch gCellBatch;
 
 // Mouse fields
 static Uint32 gMouseState;
@@ -52,20 +114,67 @@ static bool gMiddleMouseDown = false;
 // Mouse::rightButtonDown()
 // Mouse::middleButtonDown() probably not needed
 
-// Keyboard
-static bool fPressed = false;
-static bool lastFPressed = false;
+// Presses and releases go into gInputQueue as they arrive and the game
+// turns each press into one action.  gHeldInputButtons is which buttons
+// were down as of the last event taken off the queue.
+static InputQueue gInputQueue;
+static unsigned gHeldInputButtons = 0;
+static double gLastInputLatencyMs = 0.0;
 
 // Font
 static TTF_Font *gDefaultFont;
-
-// I don't know what this is for
-// Should be a static method
-static Cell defaultCell;
+// Shared by the launcher and the game, which draw with the same renderer.
+static TextAtlas gTextAtlas;
 
 // Game state
-static int uncoveredCells = 0;
-static Uint32 gTime = 0;
+// Fixed updates since the game started.  Counting steps instead of adding
+// up milliseconds means the clock can't drift with the frame rate.
+static Uint64 gGameUpdates = 0;
+// How far the next update is, 0..1, for drawing between updates.
+static double gFrameAlpha = 0.0;
+// F3 shows how long each part of a frame takes.
+static bool gShowFrameStats = false;
+static FrameStats gFrameStats;
+// F4 shows the profiler's scopes and counters on this thread, F5 writes
+// every thread's recent events to gTracePath, --trace PATH sets it.
+static bool gShowProfile = false;
+static ProfileWindow gProfileWindow;
+static std::string gTracePath;
+// With nothing held down and nothing to animate the loop blocks in
+// SDL_WaitEventTimeout until input arrives or the header clock ticks over,
+// instead of spinning.  --no-idle turns it off.
+static bool gIdleMode = true;
+static int gUpdatesUntilIdle = 0;
+static double gIdleMs = 0.0;
+static Uint64 gStartCounter = 0;
+// From the start of initGame to the first frame of the new game being
+// presented, and how much of that was initGame itself.
+static Uint64 gRestartCounter = 0;
+static double gRestartMs = 0.0;
+static double gRestartSetupMs = 0.0;
+// How long resuming the saved game took, 0 if nothing was resumed.
+static double gLoadMs = 0.0;
+// The board is a function of the seed and the difficulty.  --seed pins it.
+static bool gUseFixedSeed = false;
+static uint64_t gFixedSeed = 0;
+// Only deal boards the solver can clear from the first click without guessing.
+// --no-guess turns it on, N toggles it for the next game.
+static bool gNoGuess = false;
+// What gNoGuess was when this game started.
+static bool gGameNoGuess = false;
+// --record PATH appends every game to an archive, --replay PATH [--game N]
+// plays one back.  Space fast-forwards a replay.
+static const char *gRecordPath = nullptr;
+static ReplayRecorder gRecorder;
+static bool gRecordingGame = false;
+static bool gReplaying = false;
+static bool gReplayFastForward = false;
+static ReplayArchive gReplayArchive;
+static ReplayRecord gReplayRecord;
+static ReplayCursor gReplayCursor;
+// A game still being played at quit is saved here and picked up again at
+// the next start.  Empty if there's nowhere to put it.
+static std::string gSavePath;
 
 int main(int argc, const char * argv[])
 {
@@ -82,12 +191,90 @@ int main(int argc, const char * argv[])
         exit(1);
     }
     
+    bool benchRender = false;
+    const char *replayPath = nullptr;
+    int replayGameIndex = 0;
+    
+    for (int argIndex = 1; argIndex < argc; argIndex++)
+    {
+        std::string arg = argv[argIndex];
+        
+        if (arg == "--seed" && argIndex + 1 < argc)
+        {
+            gUseFixedSeed = true;
+            gFixedSeed = strtoull(argv[++argIndex], nullptr, 10);
+        }
+        else if (arg == "--no-guess")
+        {
+            gNoGuess = true;
+        }
+        else if (arg == "--no-idle")
+        {
+            gIdleMode = false;
+        }
+        else if (arg == "--bench-render")
+        {
+            benchRender = true;
+        }
+        else if (arg == "--trace" && argIndex + 1 < argc)
+        {
+            gTracePath = argv[++argIndex];
+        }
+        else if (arg == "--record" && argIndex + 1 < argc)
+        {
+            gRecordPath = argv[++argIndex];
+        }
+        else if (arg == "--replay" && argIndex + 1 < argc)
+        {
+            replayPath = argv[++argIndex];
+        }
+        else if (arg == "--game" && argIndex + 1 < argc)
+        {
+            replayGameIndex = atoi(argv[++argIndex]);
+        }
+        else if (arg == "--custom" && argIndex + 3 < argc)
+        {
+            int nCols = atoi(argv[++argIndex]);
+            int nRows = atoi(argv[++argIndex]);
+            int nMines = atoi(argv[++argIndex]);
+            
+            if (nCols < 1 || nRows < 1 || nMines < 0 || (long long)nCols * nRows > MAX_CUSTOM_CELLS)
+            {
+                std::cout << "Custom boards need 1 to " << MAX_CUSTOM_CELLS << " cells" << std::endl;
+                SDL_Quit();
+                TTF_Quit();
+                exit(1);
+            }
+            
+            gCustomDifficulty = { nRows, nCols, nMines };
+        }
+    }
+    
+    if (replayPath != nullptr && !loadReplay(replayPath, replayGameIndex))
+    {
+        std::cout << "Unable to load game " << replayGameIndex << " from " << replayPath << std::endl;
+        SDL_Quit();
+        TTF_Quit();
+        exit(1);
+    }
+    
+    if (benchRender)
+    {
+        gDefaultFont = loadFont("Resources/Fonts/Anonymice.ttf", 16);
+        benchmarkRenderPaths();
+        quitWindow();
+        TTF_CloseFont(gDefaultFont);
+        SDL_Quit();
+        TTF_Quit();
+        return 0;
+    }
+    
     init();
     
     gRunning = true;
     SDL_Event event;
     
-    double previous = (double)SDL_GetTicks();
+    Uint64 previous = SDL_GetPerformanceCounter();
     double lag = 0.0;
     
     while (gRunning)
@@ -100,116 +287,237 @@ int main(int argc, const char * argv[])
         // That method might be overcomplicated for what this is. Not sure.
         // What if each state is passed a keyboard and mouse in their update methods?
         // That would simplify a lot of things.
+        if (gIdleMode && isIdle())
+        {
+            waitForEvent(lag);
+        }
+        
         while (SDL_PollEvent(&event))
         {
-            switch (event.type)
+            handleEvent(event);
+        }
+        
+        Uint64 current = SDL_GetPerformanceCounter();
+        lag += getElapsedMs(previous, current);
+        previous = current;
+        
+        FrameTimings timings = { 0.0, 0.0, 0.0, 0 };
+        
+        while (lag >= MS_PER_UPDATE && timings.nUpdates < MAX_UPDATES_PER_FRAME)
+        {
+            update();
+            lag -= MS_PER_UPDATE;
+            timings.nUpdates++;
+        }
+        
+        if (lag >= MS_PER_UPDATE)
+        {
+            // Too far behind (waiting while idle, a stall, a window drag).
+            // The missed updates still count for the clock, but there's no
+            // point running them back to back.
+            int nSkipped = (int)(lag / MS_PER_UPDATE);
+            skipUpdates(nSkipped);
+            lag -= nSkipped * MS_PER_UPDATE;
+        }
+        
+        gFrameAlpha = lag / MS_PER_UPDATE;
+        
+        Uint64 updateEnd = SDL_GetPerformanceCounter();
+        render();
+        Uint64 renderEnd = SDL_GetPerformanceCounter();
+        
+        {
+            PROFILE_SCOPE("present");
+            SDL_RenderPresent(gCurrentRenderer);
+        }
+        
+        Uint64 presentEnd = SDL_GetPerformanceCounter();
+        
+        if (gRestartCounter != 0 && gState == GameState_Game)
+        {
+            recordRestartTime(presentEnd);
+        }
+        
+        timings.updateMs = getElapsedMs(current, updateEnd);
+        timings.renderMs = getElapsedMs(updateEnd, renderEnd);
+        timings.presentMs = getElapsedMs(renderEnd, presentEnd);
+        recordFrameTimings(gFrameStats, timings);
+        flushProfileCounts();
+        endProfileFrame(gProfileWindow);
+    }
+    
+    quit();
+    
+    return 0;
+}
+
+static void handleEvent(const SDL_Event &event)
+{
+    // Anything coming in might change what's on screen.
+    gUpdatesUntilIdle = IDLE_GRACE_UPDATES;
+    
+    switch (event.type)
+    {
+        case SDL_QUIT:
+            gRunning = false;
+            break;
+            
+        case SDL_RENDER_TARGETS_RESET:
+            // The board texture's contents are gone.
+            markBoardDirty();
+            break;
+            
+        case SDL_KEYDOWN:
+            switch (event.key.keysym.sym)
             {
-                case SDL_QUIT:
-                    gRunning = false;
+                case SDLK_RETURN:
+                    // This is confusing since "Game" has substates
+                    // Add win boolean.  If the game ended and win is true, win
+                    //                   If the game ended and win is false, lose
+                    if (gState == GameState_Lost ||
+                        gState == GameState_Win ||
+                        gState == GameState_Game)
+                    {
+                        quitGame();
+                        initLauncher();
+                    }
+                    break;
+
+                case SDLK_f:
+                    if (event.key.repeat == 0)
+                    {
+                        queueInputEvent(InputEventType_Press, InputButton_ToggleMode,
+                                        gMousePosition.x, gMousePosition.y, event.key.timestamp);
+                    }
+                    break;
+                    
+                case SDLK_b:
+                    gBatchedRendering = !gBatchedRendering;
+                    markBoardDirty();
                     break;
                     
-                case SDL_KEYDOWN:
-                    switch (event.key.keysym.sym)
+                case SDLK_h:
+                    if (gState == GameState_Game)
                     {
-                        case SDLK_RETURN:
-                            // This is confusing since "Game" has substates
-                            // Add win boolean.  If the game ended and win is true, win
-                            //                   If the game ended and win is false, lose
-                            if (gState == GameState_Lost ||
-                                gState == GameState_Win ||
-                                gState == GameState_Game)
-                            {
-                                quitGame();
-                                initLauncher();
-                            }
-                            break;
-
-                        case SDLK_f:
-                            if (gState == GameState_Game) {
-                                lastFPressed = fPressed;
-                                fPressed = true;
-                            }
-                            else {
-                            }
-                            break;
-                            
-                        default:
-                            break;
+                        showHint();
                     }
                     break;
-
-                case SDL_KEYUP:
-                    switch (event.key.keysym.sym) {
-                        case SDLK_f:
-                            if (gState == GameState_Game) {
-                                lastFPressed = fPressed;
-                                fPressed = false;
-                            }
-                            break;
+                    
+                case SDLK_F3:
+                    gShowFrameStats = !gShowFrameStats;
+                    break;
+                    
+                case SDLK_F4:
+                    gShowProfile = !gShowProfile;
+                    break;
+                    
+                case SDLK_F5:
+                    writeTrace();
+                    break;
+                    
+                case SDLK_UP:
+                    panBoard(0, -VIEWPORT_PAN_STEP);
+                    break;
+                    
+                case SDLK_DOWN:
+                    panBoard(0, VIEWPORT_PAN_STEP);
+                    break;
+                    
+                case SDLK_LEFT:
+                    panBoard(-VIEWPORT_PAN_STEP, 0);
+                    break;
+                    
+                case SDLK_RIGHT:
+                    panBoard(VIEWPORT_PAN_STEP, 0);
+                    break;
+                    
+                case SDLK_EQUALS:
+                case SDLK_KP_PLUS:
+                    zoomBoard(2.0, { gViewport.width / 2, GAME_HEADER_OFFSET + gViewport.height / 2 });
+                    break;
+                    
+                case SDLK_MINUS:
+                case SDLK_KP_MINUS:
+                    zoomBoard(0.5, { gViewport.width / 2, GAME_HEADER_OFFSET + gViewport.height / 2 });
+                    break;
+                    
+                case SDLK_SPACE:
+                    if (gReplaying)
+                    {
+                        gReplayFastForward = !gReplayFastForward;
                     }
                     break;
                     
-                case SDL_MOUSEBUTTONDOWN:
-                    switch (event.button.button)
+                case SDLK_n:
+                    gNoGuess = !gNoGuess;
+                    std::cout << "No-guess boards " << (gNoGuess ? "on" : "off")
+                              << " from the next game" << std::endl;
+                    
+                    if (gState != GameState_Launcher)
                     {
-                        case SDL_BUTTON_LEFT:
-                            gLeftMouseDown = true;
-                            break;
-                            
-                        case SDL_BUTTON_RIGHT:
-                            gRightMouseDown = true;
-                            break;
-                            
-                        case SDL_BUTTON_MIDDLE:
-                            gMiddleMouseDown = true;
-                            break;
-                            
-                        default:
-                            break;
+                        stockBoardPool(gBoardPool, getBoardOrder(gDifficulty));
                     }
                     break;
                     
-                case SDL_MOUSEBUTTONUP:
-                    switch (event.button.button)
+                case SDLK_p:
+                    gShowProbabilities = !gShowProbabilities;
+                    
+                    if (gShowProbabilities && gState == GameState_Game)
                     {
-                    case SDL_BUTTON_LEFT:
-                        gLeftMouseDown = false;
-                        break;
-                        
-                    case SDL_BUTTON_RIGHT:
-                        gRightMouseDown = false;
-                        break;
-                        
-                    case SDL_BUTTON_MIDDLE:
-                        gMiddleMouseDown = false;
-                        break;
-                        
-                    default:
-                        break;
+                        updateProbabilities();
                     }
                     
+                    markBoardDirty();
+                    break;
+                    
                 default:
                     break;
             }
-        }
-        
-        double current = (double)SDL_GetTicks();
-        double elapsed = current - previous;
-        lag += elapsed;
-        previous = current;
-        
-        while (lag >= MS_PER_UPDATE)
+            break;
+
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
         {
-            update();
-            lag -= elapsed;
-        }
-        
-        render();
+            bool pressed = event.type == SDL_MOUSEBUTTONDOWN;
+            InputEventType type = pressed ? InputEventType_Press : InputEventType_Release;
+            
+            // The globals are still what the launcher buttons look at.
+            switch (event.button.button)
+            {
+                case SDL_BUTTON_LEFT:
+                    gLeftMouseDown = pressed;
+                    queueInputEvent(type, InputButton_Left,
+                                    event.button.x, event.button.y, event.button.timestamp);
+                    break;
+                    
+                case SDL_BUTTON_RIGHT:
+                    gRightMouseDown = pressed;
+                    queueInputEvent(type, InputButton_Right,
+                                    event.button.x, event.button.y, event.button.timestamp);
+                    break;
+                    
+                case SDL_BUTTON_MIDDLE:
+                    gMiddleMouseDown = pressed;
+                    queueInputEvent(type, InputButton_Middle,
+                                    event.button.x, event.button.y, event.button.timestamp);
+                    break;
+                    
+                default:
+                    break;
+            }
+        } break;
+            
+        case SDL_MOUSEWHEEL:
+            // Each notch doubles or halves the zoom around the cursor.
+            if (event.wheel.y != 0)
+            {
+                zoomBoard(event.wheel.y > 0 ? 2.0 : 0.5, gMousePosition);
+            }
+            break;
+
+        default:
+            break;
     }
-    
-    quit();
-    
-    return 0;
 }
 
 static void init()
@@ -217,45 +525,108 @@ static void init()
     gDefaultFont = loadFont("Resources/Fonts/Anonymice.ttf", 16);
     gMouseState = SDL_GetMouseState(&gMousePosition.x, &gMousePosition.y);
     gState = GameState_Launcher;
-    initLauncher();
+    gStartCounter = SDL_GetPerformanceCounter();
+    nameProfileThread("main");
+    initProfileWindow(gProfileWindow);
+    startWorkPool(gWorkPool, 0);
+    startBoardPool(gBoardPool);
+    initWindow();
+    
+    char *prefPath = SDL_GetPrefPath("centuryapps", "Minesweeper1");
+    
+    if (prefPath != nullptr)
+    {
+        gSavePath = std::string(prefPath) + SAVE_FILE_NAME;
+        
+        if (gTracePath.empty())
+        {
+            gTracePath = std::string(prefPath) + TRACE_FILE_NAME;
+        }
+        
+        SDL_free(prefPath);
+    }
+    
+    if (gReplaying)
+    {
+        gState = GameState_Game;
+        initGame();
+    }
+    else if (!resumeSavedGame())
+    {
+        initLauncher();
+    }
 }
 
-static void initLauncher()
+static void initWindow()
 {
-    gLeftMouseDown = false;
-    gRightMouseDown = false;
-    gMiddleMouseDown = false;
-    
-    gLauncherWindow = SDL_CreateWindow(LAUNCHER_TITLE,
-                                                  LAUNCHER_POSX,
-                                                  LAUNCHER_POSY,
-                                                  LAUNCHER_WIDTH,
-                                                  LAUNCHER_HEIGHT,
-                                                  LAUNCHER_FLAGS);
-    
-    if (gLauncherWindow == nullptr)
+    gWindow = SDL_CreateWindow(LAUNCHER_TITLE,
+                               WINDOW_POSX,
+                               WINDOW_POSY,
+                               LAUNCHER_WIDTH,
+                               LAUNCHER_HEIGHT,
+                               WINDOW_FLAGS);
+    
+    if (gWindow == nullptr)
     {
-        std::cout << "Unable to create launcher window" << std::endl;
+        std::cout << "Unable to create window" << std::endl;
         SDL_Quit();
         TTF_Quit();
         exit(1);
     }
     
-    gLauncherRenderer = SDL_CreateRenderer(gLauncherWindow,
-                                           -1,
-                                           LAUNCHER_RENDERER_FLAGS);
+    gRenderer = SDL_CreateRenderer(gWindow,
+                                   -1,
+                                   RENDERER_FLAGS);
     
-    if (gLauncherRenderer == nullptr)
+    if (gRenderer == nullptr)
     {
-        std::cout << "Unable to create launcher renderer" << std::endl;
+        std::cout << "Unable to create renderer" << std::endl;
         SDL_Quit();
         TTF_Quit();
         exit(1);
     }
     
-    gCurrentRenderer = gLauncherRenderer;
+    gCurrentRenderer = gRenderer;
+    initTextAtlas(gTextAtlas, gRenderer);
+    initLauncherButtons();
+    SDL_SetRenderDrawBlendMode(gCurrentRenderer, SDL_BLENDMODE_BLEND);
+}
+
+static void quitWindow()
+{
+    logTextAtlasStats(gTextAtlas);
+    quitTextAtlas(gTextAtlas);
+    quitBoardChunks();
+    SDL_DestroyRenderer(gRenderer);
+    SDL_DestroyWindow(gWindow);
+    
+    gRenderer = nullptr;
+    gCurrentRenderer = nullptr;
+    gWindow = nullptr;
+}
+
+static void initLauncher()
+{
+    gState = GameState_Launcher;
+    gLeftMouseDown = false;
+    gRightMouseDown = false;
+    gMiddleMouseDown = false;
+    
+    SDL_SetWindowTitle(gWindow, LAUNCHER_TITLE);
+    SDL_SetWindowSize(gWindow, LAUNCHER_WIDTH, LAUNCHER_HEIGHT);
     
-    int nButtons = 3;
+    for (int buttonIndex = 0;
+         buttonIndex < launcherButtons.size();
+         buttonIndex++)
+    {
+        launcherButtons[buttonIndex].state = ButtonState_None;
+    }
+}
+
+// Made once, the launcher scene keeps them.
+static void initLauncherButtons()
+{
+    int nButtons = 4;
     
     launcherButtons.push_back({
         "Easy",  // text
@@ -269,12 +640,11 @@ static void initLauncher()
         },  // position
         ButtonState_None,  // state
         []() {
-            setDifficulty({
-                16,  // nRows
-                16,  // nCols
-                24,  // nMines
-            });
-        }  // pressedCallback
+            setDifficulty(DIFFICULTY_EASY);
+        },  // pressedCallback
+        []() {
+            stockBoardPool(gBoardPool, getBoardOrder(DIFFICULTY_EASY));
+        }  // hoveredCallback
     });
     
     launcherButtons.push_back({
@@ -289,12 +659,11 @@ static void initLauncher()
         },  // position
         ButtonState_None,  // state
         []() {
-            setDifficulty({
-                32,  // nRows
-                32,  // nCols
-                100,  // nMines
-            });
-        }  // pressedCallback
+            setDifficulty(DIFFICULTY_MEDIUM);
+        },  // pressedCallback
+        []() {
+            stockBoardPool(gBoardPool, getBoardOrder(DIFFICULTY_MEDIUM));
+        }  // hoveredCallback
     });
     
     launcherButtons.push_back({
@@ -309,31 +678,48 @@ static void initLauncher()
         },  // position
         ButtonState_None,  // state
         []() {
-            setDifficulty({
-                64,  // nRows
-                64,  // nCols
-                400,  // nMines
-            });
-        }  // pressedCallback
+            setDifficulty(DIFFICULTY_HARD);
+        },  // pressedCallback
+        []() {
+            stockBoardPool(gBoardPool, getBoardOrder(DIFFICULTY_HARD));
+        }  // hoveredCallback
     });
     
-    SDL_SetRenderDrawBlendMode(gCurrentRenderer, SDL_BLENDMODE_BLEND);
+    launcherButtons.push_back({
+        "Custom",  // text
+        {
+            LAUNCHER_BUTTON_WIDTH,
+            LAUNCHER_BUTTON_HEIGHT
+        },  // size
+        {
+            LAUNCHER_WIDTH / 2 - LAUNCHER_BUTTON_WIDTH / 2,
+            LAUNCHER_HEIGHT / (nButtons + 1) * ((int)launcherButtons.size() + 1)
+        },  // position
+        ButtonState_None,  // state
+        []() {
+            setDifficulty(gCustomDifficulty);
+        },  // pressedCallback
+        []() {
+            stockBoardPool(gBoardPool, getBoardOrder(gCustomDifficulty));
+        }  // hoveredCallback
+    });
 }
 
 static void quit()
 {
-    switch (gState)
+    saveCurrentGame();
+    
+    if (gState != GameState_Launcher)
     {
-        case GameState_Launcher:
-            quitLauncher();
-            break;
-            
-        default:
-            quitGame();
-            break;
+        quitGame();
     }
     
+    quitWindow();
     TTF_CloseFont(gDefaultFont);
+    stopWorkPool(gWorkPool);
+    stopBoardPool(gBoardPool);
+    closeReplayArchive(gReplayArchive);
+    logCpuUse();
     
     SDL_Quit();
     TTF_Quit();
@@ -342,104 +728,232 @@ static void quit()
 static void quitLauncher()
 {
     gState = GameState_Game;
-    
-    SDL_DestroyRenderer(gLauncherRenderer);
-    SDL_DestroyWindow(gLauncherWindow);
-    
-    gLauncherRenderer = nullptr;
-    gLauncherWindow = nullptr;
-    
     initGame();
 }
 
 static void quitGame()
 {
     gState = GameState_Launcher;
-    SDL_DestroyRenderer(gGameRenderer);
-    SDL_DestroyWindow(gGameWindow);
-    
-    gGameRenderer = nullptr;
-    gGameWindow = nullptr;
+    finishGameRecording();
+    // Back in the launcher it's the player's turn again.
+    gReplaying = false;
 }
 
+// Only the board and what's derived from it are reset, the window,
+// renderer and textures carry over from the last game.
 static void initGame()
 {
-    uncoveredCells = 0;
-    gTime = 0;
+    gRestartCounter = SDL_GetPerformanceCounter();
+    gGameUpdates = 0;
     gLeftMouseDown = false;
     gRightMouseDown = false;
     gMiddleMouseDown = false;
-    gameCells.clear();
     gMouseMode = MouseMode_ClearMode;
+    fitWindowToBoard();
     
-    int gameWidth = gDifficulty.nRows * CELL_WIDTH;
-    int gameHeight = gDifficulty.nCols * CELL_HEIGHT + GAME_HEADER_OFFSET;
+    // A restart from inside the game doesn't go through quitGame.
+    finishGameRecording();
     
-    gameWindowSize = {
-        gameWidth,
-        gameHeight
-    };
+    gGameNoGuess = gNoGuess;
     
-    gGameWindow = SDL_CreateWindow(GAME_TITLE,
-                                   GAME_POSX,
-                                   GAME_POSY,
-                                   gameWidth,
-                                   gameHeight,
-                                   GAME_FLAGS);
+    if (gReplaying)
+    {
+        gGameNoGuess = (gReplayRecord.header.flags & REPLAY_FLAG_NO_GUESS) != 0;
+        startReplayGame(gGame, gReplayRecord.header);
+        initSolver(gSolver, gGame.board);
+        startReplayCursor(gReplayCursor, gReplayRecord);
+    }
+    else
+    {
+        // The game was made on the pool's thread, usually while the player
+        // was still in the launcher, so this is a swap.  Without one ready
+        // the board is cleared here and the mines go down on the first
+        // click instead, see sendGameCommand.
+        stockBoardPool(gBoardPool, getBoardOrder(gDifficulty));
+        takeBoard(gBoardPool, gGame, gSolver);
+    }
     
-    if (gGameWindow == nullptr)
+    if (!gReplaying && gRecordPath != nullptr)
     {
-        std::cout << "Unable to create game window" << std::endl;
-        SDL_Quit();
-        TTF_Quit();
-        exit(1);
+        startRecording(gRecorder, gGame.seed, gDifficulty,
+                       (gGameNoGuess ? REPLAY_FLAG_NO_GUESS : 0) |
+                       (gGame.clearStartBlockOnReveal ? REPLAY_FLAG_MINES_FIRST : 0));
+        gRecordingGame = true;
+        std::cout << "Recording game with seed " << gGame.seed << std::endl;
     }
     
-    gGameRenderer = SDL_CreateRenderer(gGameWindow,
-                                       -1,
-                                       GAME_RENDERER_FLAGS);
+    startGameView();
+    gRestartSetupMs = getElapsedMs(gRestartCounter, SDL_GetPerformanceCounter());
+}
+
+// The window fits the board if it can, anything bigger scrolls.
+static void fitWindowToBoard()
+{
+    int boardWidth = gDifficulty.nCols * CELL_WIDTH;
+    int boardHeight = gDifficulty.nRows * CELL_HEIGHT;
+    int maxWidth = GAME_MAX_WIDTH;
+    int maxHeight = GAME_MAX_HEIGHT;
+    SDL_Rect usableBounds;
     
-    if (gGameRenderer == nullptr)
+    if (SDL_GetDisplayUsableBounds(0, &usableBounds) == 0)
     {
-        std::cout << "Unable to create game renderer" << std::endl;
-        SDL_Quit();
-        TTF_Quit();
-        exit(1);
+        maxWidth = usableBounds.w - GAME_WINDOW_MARGIN;
+        maxHeight = usableBounds.h - GAME_WINDOW_MARGIN;
     }
     
-    gCurrentRenderer = gGameRenderer;
+    int gameWidth = std::max(std::min(boardWidth, maxWidth), GAME_MIN_WIDTH);
+    int gameHeight = std::min(boardHeight + GAME_HEADER_OFFSET, maxHeight);
+    
+    initViewport(gViewport, gameWidth, gameHeight - GAME_HEADER_OFFSET, boardWidth, boardHeight);
+    
+    gameWindowSize = {
+        gameWidth,
+        gameHeight
+    };
+    
+    SDL_SetWindowTitle(gWindow, GAME_TITLE);
+    SDL_SetWindowSize(gWindow, gameWidth, gameHeight);
+}
+
+// Everything drawn or hinted about the last game goes.
+static void startGameView()
+{
+    clearInputQueue(gInputQueue);
+    gHeldInputButtons = 0;
+    gHintCellIndex = -1;
     
-    for (int y = 0; y < gDifficulty.nCols; y++)
+    if (gShowProbabilities)
     {
-        for (int x = 0; x < gDifficulty.nRows; x++)
-        {
-            Cell cell;
-            cell.position = {
-                x * CELL_WIDTH,
-                y * CELL_HEIGHT + GAME_HEADER_OFFSET
-            };
-            
-            gameCells.push_back(cell);
-        }
+        updateProbabilities();
     }
     
-    putMinesInNRandomCells(gDifficulty.nMines);
-    assignCellsAdjacentMineCounts();
-    
-    SDL_SetRenderDrawBlendMode(gCurrentRenderer, SDL_BLENDMODE_BLEND);
+    initBoardChunks();
 }
 
-static void update()
+// Picks up the game that was being played at the last quit, if there was
+// one.  It's only ever resumed once: the save goes as soon as it's loaded.
+static bool resumeSavedGame()
 {
-    gMouseState = SDL_GetMouseState(&gMousePosition.x, &gMousePosition.y);
+    Uint64 start = SDL_GetPerformanceCounter();
+    SaveExtras extras;
     
-    switch (gState)
+    if (gSavePath.empty() || !loadGame(gGame, extras, gSavePath.c_str()))
     {
-        case GameState_Launcher:
-            updateLauncher();
-            break;
-            
-        case GameState_Game:
+        return false;
+    }
+    
+    gLoadMs = getElapsedMs(start, SDL_GetPerformanceCounter());
+    remove(gSavePath.c_str());
+    
+    gState = GameState_Game;
+    gDifficulty = gGame.difficulty;
+    gGameUpdates = extras.updates;
+    gMouseMode = extras.mouseMode == MouseMode_FlagMode ? MouseMode_FlagMode : MouseMode_ClearMode;
+    gGameNoGuess = extras.noGuess;
+    gLeftMouseDown = false;
+    gRightMouseDown = false;
+    gMiddleMouseDown = false;
+    
+    fitWindowToBoard();
+    initSolver(gSolver, gGame.board);
+    startGameView();
+    
+    return true;
+}
+
+// Games that are over, or only being watched, aren't worth coming back to.
+static void saveCurrentGame()
+{
+    if (gSavePath.empty() || gState != GameState_Game || gReplaying)
+    {
+        return;
+    }
+    
+    PROFILE_SCOPE("saveGame");
+    SaveExtras extras = {
+        gGameUpdates,
+        gMouseMode,
+        gGameNoGuess
+    };
+    
+    if (!saveGame(gGame, extras, gSavePath.c_str()))
+    {
+        std::cout << "Unable to save the game to " << gSavePath << std::endl;
+    }
+}
+
+// No-guess boards are laid out around the first click, so those are only
+// cleared ahead of time.
+static BoardOrder getBoardOrder(Difficulty difficulty)
+{
+    BoardOrder order = {
+        difficulty,
+        !gNoGuess,  // layOutMines
+        gUseFixedSeed,
+        gFixedSeed
+    };
+    
+    return order;
+}
+
+static void recordRestartTime(Uint64 presentEnd)
+{
+    // Shown in the F3 overlay.
+    gRestartMs = getElapsedMs(gRestartCounter, presentEnd);
+    gRestartCounter = 0;
+}
+
+static void initBoardChunks()
+{
+    gDirtyCells.clear();
+    gCellIsDirty.assign(gGame.board.nCells, false);
+    gHoveredCellIndex = -1;
+    
+    // renderGame falls back to drawing the visible cells every frame.
+    gChunkTexturesSupported = SDL_RenderTargetSupported(gCurrentRenderer);
+    
+    if (gChunkedBoardSize.x == gGame.board.width &&
+        gChunkedBoardSize.y == gGame.board.height)
+    {
+        markBoardDirty();
+        return;
+    }
+    
+    destroyChunkTextures();
+    
+    gChunkedBoardSize = { gGame.board.width, gGame.board.height };
+    gChunkCols = (gGame.board.width + CHUNK_CELLS - 1) / CHUNK_CELLS;
+    gChunkRows = (gGame.board.height + CHUNK_CELLS - 1) / CHUNK_CELLS;
+    
+    BoardChunk emptyChunk = { nullptr, 0, true, 0 };
+    gChunks.assign(gChunkCols * gChunkRows, emptyChunk);
+}
+
+static void quitBoardChunks()
+{
+    destroyChunkTextures();
+    gChunks.clear();
+    gChunkedBoardSize = { 0, 0 };
+}
+
+static void update()
+{
+    PROFILE_SCOPE("update");
+    
+    if (gUpdatesUntilIdle > 0)
+    {
+        gUpdatesUntilIdle--;
+    }
+    
+    gMouseState = SDL_GetMouseState(&gMousePosition.x, &gMousePosition.y);
+    
+    switch (gState)
+    {
+        case GameState_Launcher:
+            updateLauncher();
+            break;
+            
+        case GameState_Game:
             updateGame();
             break;
             
@@ -470,73 +984,174 @@ static void updateGame()
         updateButton(gameButtons[buttonIndex]);
     }
 
-    if (fPressed && !lastFPressed) {
-        if (gMouseMode == MouseMode_ClearMode) {
-            gMouseMode = MouseMode_FlagMode;
-        }
-        else if (gMouseMode == MouseMode_FlagMode) {
-            gMouseMode = MouseMode_ClearMode;
+    if (gReplaying)
+    {
+        // The mouse doesn't get a say in a replay.
+        clearInputQueue(gInputQueue);
+        
+        int nUpdates = gReplayFastForward ? REPLAY_FAST_FORWARD_UPDATES : 1;
+        
+        for (int updateIndex = 0;
+             updateIndex < nUpdates && gState == GameState_Game;
+             updateIndex++)
+        {
+            sendDueReplayCommands();
+            gGameUpdates++;
         }
-        lastFPressed = fPressed;
+        
+        return;
+    }
+    
+    InputEvent event;
+    
+    // A game that ends halfway through leaves the rest for nobody.
+    while (gState == GameState_Game && popInputEvent(gInputQueue, event))
+    {
+        handleInputEvent(event);
     }
+    
+    gGameUpdates++;
+}
 
-    if (mouseIsTouchingCell())
+// Commands go in on the same update they went in on when they were
+// recorded, so the game and its clock come out the same.
+static void sendDueReplayCommands()
+{
+    ReplayCommand command;
+    
+    while (gState == GameState_Game &&
+           peekReplayCommand(gReplayCursor, command) &&
+           command.time <= gGameUpdates)
     {
-        Cell &cell = getCellAtPosition(gMousePosition);
-        
-        switch (cell.state)
+        nextReplayCommand(gReplayCursor, command);
+        sendGameCommand(command.command);
+    }
+}
+
+static bool loadReplay(const char *path, int gameIndex)
+{
+    if (!openReplayArchive(gReplayArchive, path))
+    {
+        return false;
+    }
+    
+    for (int recordIndex = 0; recordIndex <= gameIndex; recordIndex++)
+    {
+        if (!nextReplayRecord(gReplayArchive, gReplayRecord))
         {
-            case CellState_Closed:
-            {
-                if (mouseButtonDown(MouseButton_Left))
-                {
-                    if (gMouseMode == MouseMode_ClearMode) {
-                        if (cell.hasMine && !cell.hasFlag)
-                        {
-                            loseGame();
-                        }
-                        else if (!cell.hasFlag)
-                        {
-                            uncoverPartOfBoard(cell);
-                        }
-                        
-                        int nCells = gDifficulty.nCols * gDifficulty.nRows;
-                        
-                        if (nCells - uncoveredCells == gDifficulty.nMines)
-                        {
-                            winGame();
-                        }
-                    }
-                    else if (gMouseMode == MouseMode_FlagMode) {
-                        if (cell.hadFlag) {
-                            cell.hasFlag = false;
-                        }
-                        else {
-                            cell.hasFlag = true;
-                        }
-                    }
-                }
-                else {
-                    if (cell.hasFlag) {
-                        cell.hadFlag = true;
-                    }
-                    else {
-                        cell.hadFlag = false;
-                    }
-                }
-                
-                break;
-            }
-                
-            case CellState_Open:
-                break;
-                
-            default:
-                break;
+            closeReplayArchive(gReplayArchive);
+            return false;
         }
     }
     
-    gTime += MS_PER_UPDATE;
+    gReplaying = true;
+    gDifficulty = gReplayRecord.header.difficulty;
+    std::cout << "Replaying " << gReplayRecord.header.nCommands << " commands over "
+              << gReplayRecord.header.duration * MS_PER_UPDATE / 1000.0 << " s" << std::endl;
+    
+    return true;
+}
+
+// Appends the game to the archive unless nothing was ever sent to it.
+static void finishGameRecording()
+{
+    if (!gRecordingGame)
+    {
+        return;
+    }
+    
+    gRecordingGame = false;
+    
+    if (gRecorder.header.nCommands == 0)
+    {
+        return;
+    }
+    
+    finishRecording(gRecorder, gGame.status);
+    
+    if (!appendRecording(gRecorder, gRecordPath))
+    {
+        std::cout << "Unable to write replay to " << gRecordPath << std::endl;
+    }
+}
+
+static void queueInputEvent(InputEventType type, InputButton button, int x, int y, Uint32 timestamp)
+{
+    if (gState != GameState_Game)
+    {
+        return;
+    }
+    
+    InputEvent event = {
+        type,
+        button,
+        x,
+        y,
+        timestamp
+    };
+    
+    // Dropped when the queue's full, counted in the F3 overlay.
+    pushInputEvent(gInputQueue, event);
+}
+
+// Presses turn into actions, releases only change what's held.  Holding one
+// mouse button and pressing the other chords, like the middle button does.
+static void handleInputEvent(const InputEvent &event)
+{
+    unsigned buttonBit = 1u << event.button;
+    
+    if (event.type == InputEventType_Release)
+    {
+        gHeldInputButtons &= ~buttonBit;
+        return;
+    }
+    
+    unsigned heldBefore = gHeldInputButtons;
+    gHeldInputButtons |= buttonBit;
+    
+    if (event.button == InputButton_ToggleMode)
+    {
+        gMouseMode = gMouseMode == MouseMode_ClearMode ? MouseMode_FlagMode : MouseMode_ClearMode;
+        return;
+    }
+    
+    int cellIndex = getCellIndexAtPosition({ event.x, event.y });
+    
+    if (cellIndex < 0)
+    {
+        return;
+    }
+    
+    bool otherMouseButtonHeld =
+        (event.button == InputButton_Left && (heldBefore & (1u << InputButton_Right))) ||
+        (event.button == InputButton_Right && (heldBefore & (1u << InputButton_Left)));
+    
+    if (event.button == InputButton_Middle || otherMouseButtonHeld)
+    {
+        sendGameCommand({ CommandType_Chord, cellIndex });
+    }
+    else if (event.button == InputButton_Left && gMouseMode == MouseMode_ClearMode)
+    {
+        sendGameCommand({ CommandType_Reveal, cellIndex });
+    }
+    else
+    {
+        toggleFlag(cellIndex);
+    }
+    
+    gLastInputLatencyMs = (double)(SDL_GetTicks() - event.timestamp);
+}
+
+static void toggleFlag(int cellIndex)
+{
+    if (cellHasFlag(gGame.board, cellIndex))
+    {
+        sendGameCommand({ CommandType_Unflag, cellIndex });
+    }
+    else
+    {
+        sendGameCommand({ CommandType_Flag, cellIndex });
+    }
 }
 
 static void updateButton(Button &button)
@@ -547,6 +1162,11 @@ static void updateButton(Button &button)
             if (mouseOverButton(button))
             {
                 button.state = ButtonState_Hover;
+                
+                if (button.hoveredCallback)
+                {
+                    button.hoveredCallback();
+                }
             }
             break;
             
@@ -582,7 +1202,9 @@ static void updateButton(Button &button)
 
 static void render()
 {
+    PROFILE_SCOPE("render");
     SDL_SetRenderDrawColor(gCurrentRenderer, 0, 0, 0, 255);
+    PROFILE_COUNT("render calls", 1);
     SDL_RenderClear(gCurrentRenderer);
     
     switch (gState)
@@ -610,6 +1232,8 @@ static void render()
                 gameWindowSize.x / 2,
                 22
             }, { 255, 255, 255 });
+            renderHeaderClock();
+            renderHeaderMineCounter();
             renderGame();
         } break;
             
@@ -627,71 +1251,965 @@ static void render()
             
         case GameState_Win:
         {
-            renderGame();
-            std::string winString = "You Won in " + std::to_string(gTime / 1000) + " seconds.";
-            
-            renderText("Press Enter to Restart", {
-                gameWindowSize.x / 2,
-                8
-            }, { 255, 255, 255 });
-            renderText(winString.c_str(), {
-                gameWindowSize.x / 2,
-                22
-            }, { 255, 255, 255 });
+            renderGame();
+            std::string winString = "You Won in " + std::to_string((int)(getGameTimeMs() / 1000)) + " seconds.";
+            
+            renderText("Press Enter to Restart", {
+                gameWindowSize.x / 2,
+                8
+            }, { 255, 255, 255 });
+            renderText(winString.c_str(), {
+                gameWindowSize.x / 2,
+                22
+            }, { 255, 255, 255 });
+        }
+            break;
+            
+        default:
+            break;
+    }
+    
+    if (gShowFrameStats)
+    {
+        renderFrameStats();
+    }
+    
+    if (gShowProfile)
+    {
+        renderProfile();
+    }
+}
+
+static bool isIdle()
+{
+    if (gUpdatesUntilIdle > 0)
+    {
+        return false;
+    }
+    
+    // Presses and releases are events, so held buttons don't need watching.
+    // The overlays are measuring frames, they need them to keep coming,
+    // and a replay has commands coming in on their own.
+    return !gShowFrameStats && !gShowProfile && !(gReplaying && gState == GameState_Game);
+}
+
+// -1 when there's no clock on screen.
+static int getMsUntilClockTick(double lag)
+{
+    if (gState != GameState_Game)
+    {
+        return -1;
+    }
+    
+    double timeMs = (gGameUpdates + lag / MS_PER_UPDATE) * MS_PER_UPDATE;
+    double nextTickMs = (floor(timeMs / 1000.0) + 1.0) * 1000.0;
+    
+    return std::max((int)ceil(nextTickMs - timeMs), 1);
+}
+
+// Blocks until something happens.  lag is the time since the last update,
+// so the wait can end right when the clock needs a new second.
+static void waitForEvent(double lag)
+{
+    SDL_Event event;
+    int timeoutMs = getMsUntilClockTick(lag);
+    Uint64 start = SDL_GetPerformanceCounter();
+    
+    int gotEvent = timeoutMs < 0 ? SDL_WaitEvent(&event) : SDL_WaitEventTimeout(&event, timeoutMs);
+    
+    gIdleMs += getElapsedMs(start, SDL_GetPerformanceCounter());
+    
+    if (gotEvent)
+    {
+        handleEvent(event);
+    }
+}
+
+// Updates that were owed but not run.  Nothing happened during them, but
+// the clock still has to move.
+static void skipUpdates(int nUpdates)
+{
+    if (gState == GameState_Game)
+    {
+        gGameUpdates += nUpdates;
+    }
+}
+
+static void logCpuUse()
+{
+    double wallSeconds = getElapsedMs(gStartCounter, SDL_GetPerformanceCounter()) / 1000.0;
+    double cpuSeconds = (double)clock() / CLOCKS_PER_SEC;
+    
+    std::cout << "CPU " << cpuSeconds << " s over " << wallSeconds << " s ("
+              << 100.0 * cpuSeconds / std::max(wallSeconds, 0.001) << "%), "
+              << gIdleMs / 1000.0 << " s idle" << std::endl;
+}
+
+static void renderHeaderClock()
+{
+    char seconds[16];
+    snprintf(seconds, sizeof(seconds), "%3d", (int)(gGameUpdates * MS_PER_UPDATE / 1000.0));
+    
+    renderTextLeft(seconds, {
+        gameWindowSize.x - HEADER_CLOCK_WIDTH,
+        22 - FRAME_STATS_LINE_HEIGHT / 2
+    }, { 255, 255, 255 });
+}
+
+static void renderHeaderMineCounter()
+{
+    char minesLeft[16];
+    snprintf(minesLeft, sizeof(minesLeft), "%3d", getMinesLeft(gGame));
+    
+    renderTextLeft(minesLeft, {
+        HEADER_MINE_COUNTER_X,
+        22 - FRAME_STATS_LINE_HEIGHT / 2
+    }, { 255, 255, 255 });
+}
+
+static double getElapsedMs(Uint64 start, Uint64 end)
+{
+    return (double)(end - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+// Game time, including the part of an update that has passed since the
+// last one while the game is running, so the clock moves smoothly.
+static double getGameTimeMs()
+{
+    double updates = (double)gGameUpdates;
+    
+    if (gState == GameState_Game)
+    {
+        updates += gFrameAlpha;
+    }
+    
+    return updates * MS_PER_UPDATE;
+}
+
+static void recordFrameTimings(FrameStats &stats, FrameTimings timings)
+{
+    if (stats.nFrames == 0)
+    {
+        stats.sum = { 0.0, 0.0, 0.0, 0 };
+        stats.worst = { 0.0, 0.0, 0.0, 0 };
+        
+        if (stats.windowStart == 0)
+        {
+            stats.windowStart = SDL_GetPerformanceCounter();
+        }
+    }
+    
+    stats.sum.updateMs += timings.updateMs;
+    stats.sum.renderMs += timings.renderMs;
+    stats.sum.presentMs += timings.presentMs;
+    stats.sum.nUpdates += timings.nUpdates;
+    stats.worst.updateMs = std::max(stats.worst.updateMs, timings.updateMs);
+    stats.worst.renderMs = std::max(stats.worst.renderMs, timings.renderMs);
+    stats.worst.presentMs = std::max(stats.worst.presentMs, timings.presentMs);
+    stats.worst.nUpdates = std::max(stats.worst.nUpdates, timings.nUpdates);
+    stats.nFrames++;
+    
+    if (stats.nFrames < FRAME_STATS_WINDOW)
+    {
+        return;
+    }
+    
+    Uint64 now = SDL_GetPerformanceCounter();
+    double windowMs = getElapsedMs(stats.windowStart, now);
+    
+    stats.shownAverage = {
+        stats.sum.updateMs / stats.nFrames,
+        stats.sum.renderMs / stats.nFrames,
+        stats.sum.presentMs / stats.nFrames,
+        0
+    };
+    stats.shownWorst = stats.worst;
+    stats.shownFps = stats.nFrames * 1000.0 / windowMs;
+    stats.shownUpdatesPerSecond = stats.sum.nUpdates * 1000.0 / windowMs;
+    stats.windowStart = now;
+    stats.nFrames = 0;
+}
+
+static void renderFrameStats()
+{
+    const FrameTimings &average = gFrameStats.shownAverage;
+    const FrameTimings &worst = gFrameStats.shownWorst;
+    const int nLines = FRAME_STATS_LINES;
+    char lines[nLines][64];
+    
+    snprintf(lines[0], sizeof(lines[0]), "         avg   max ms");
+    snprintf(lines[1], sizeof(lines[1]), "update  %5.2f %5.2f", average.updateMs, worst.updateMs);
+    snprintf(lines[2], sizeof(lines[2]), "render  %5.2f %5.2f", average.renderMs, worst.renderMs);
+    snprintf(lines[3], sizeof(lines[3]), "present %5.2f %5.2f", average.presentMs, worst.presentMs);
+    snprintf(lines[4], sizeof(lines[4]), "%3.0f fps %3.0f ups t %.2f",
+             gFrameStats.shownFps, gFrameStats.shownUpdatesPerSecond, getGameTimeMs() / 1000.0);
+    snprintf(lines[5], sizeof(lines[5]), "input %.0f ms, %d dropped",
+             gLastInputLatencyMs, gInputQueue.nDropped);
+    snprintf(lines[6], sizeof(lines[6]), "restart %.1f ms, %.1f reset, %.1f load",
+             gRestartMs, gRestartSetupMs, gLoadMs);
+    
+    SDL_Rect background = { 0, 0, 0, nLines * FRAME_STATS_LINE_HEIGHT + 4 };
+    int windowWidth = 0;
+    SDL_GetRendererOutputSize(gCurrentRenderer, &windowWidth, nullptr);
+    background.w = windowWidth;
+    
+    SDL_SetRenderDrawColor(gCurrentRenderer, 0, 0, 0, 191);
+    PROFILE_COUNT("render calls", 1);
+    SDL_RenderFillRect(gCurrentRenderer, &background);
+    
+    for (int lineIndex = 0; lineIndex < nLines; lineIndex++)
+    {
+        renderTextLeft(lines[lineIndex], {
+            2,
+            2 + lineIndex * FRAME_STATS_LINE_HEIGHT
+        }, { 255, 255, 255 });
+    }
+}
+
+// Per-frame totals over the last PROFILE_WINDOW_FRAMES frames, under the
+// frame stats when they're up too.
+static void renderProfile()
+{
+    const int maxLines = 24;
+    char lines[maxLines][64];
+    int nLines = 0;
+    
+    snprintf(lines[nLines++], sizeof(lines[0]), "                   p50   p95   p99");
+    
+#ifdef MINESWEEPER_NO_PROFILER
+    snprintf(lines[nLines++], sizeof(lines[0]), "profiler compiled out");
+#endif
+    
+    for (int seriesIndex = 0;
+         seriesIndex < gProfileWindow.series.size() && nLines < maxLines;
+         seriesIndex++)
+    {
+        const ProfileSeries &series = gProfileWindow.series[seriesIndex];
+        const char *format = series.type == ProfileEventType_Scope ? "%-18.18s%6.2f%6.2f%6.2f" :
+                                                                     "%-18.18s%6.0f%6.0f%6.0f";
+        
+        snprintf(lines[nLines++], sizeof(lines[0]), format, series.name,
+                 getProfilePercentile(gProfileWindow, series, 0.5),
+                 getProfilePercentile(gProfileWindow, series, 0.95),
+                 getProfilePercentile(gProfileWindow, series, 0.99));
+    }
+    
+    int top = gShowFrameStats ? FRAME_STATS_LINES * FRAME_STATS_LINE_HEIGHT + 4 : 0;
+    SDL_Rect background = { 0, top, 0, nLines * FRAME_STATS_LINE_HEIGHT + 4 };
+    int windowWidth = 0;
+    SDL_GetRendererOutputSize(gCurrentRenderer, &windowWidth, nullptr);
+    background.w = windowWidth;
+    
+    SDL_SetRenderDrawColor(gCurrentRenderer, 0, 0, 0, 191);
+    PROFILE_COUNT("render calls", 1);
+    SDL_RenderFillRect(gCurrentRenderer, &background);
+    
+    for (int lineIndex = 0; lineIndex < nLines; lineIndex++)
+    {
+        renderTextLeft(lines[lineIndex], {
+            2,
+            top + 2 + lineIndex * FRAME_STATS_LINE_HEIGHT
+        }, { 255, 255, 255 });
+    }
+}
+
+static void writeTrace()
+{
+    if (gTracePath.empty())
+    {
+        std::cout << "Nowhere to write a trace, --trace PATH sets where" << std::endl;
+    }
+    else if (writeProfileTrace(gTracePath.c_str()))
+    {
+        std::cout << "Wrote a trace to " << gTracePath << std::endl;
+    }
+    else
+    {
+        std::cout << "Unable to write a trace to " << gTracePath << std::endl;
+    }
+}
+
+static void renderLauncher()
+{
+    for (int buttonIndex = 0;
+         buttonIndex < launcherButtons.size();
+         buttonIndex++)
+    {
+        renderButton(launcherButtons[buttonIndex]);
+    }
+}
+
+static void renderGame()
+{
+    PROFILE_SCOPE("renderGame");
+    for (int buttonIndex = 0;
+         buttonIndex < gameButtons.size();
+         buttonIndex++)
+    {
+        renderButton(gameButtons[buttonIndex]);
+    }
+    
+    SDL_Rect boardRect = {
+        0,
+        GAME_HEADER_OFFSET,
+        gViewport.width,
+        gViewport.height
+    };
+    
+    ChunkRange range = getVisibleChunks();
+    updateHoveredCell();
+    
+    if (gChunkTexturesSupported)
+    {
+        patchBoardChunks(range);
+    }
+    
+    // Chunks at the edge stick out of the view, but not into the header.
+    SDL_RenderSetClipRect(gCurrentRenderer, &boardRect);
+    
+    if (!gChunkTexturesSupported)
+    {
+        setCellTransformForScreen();
+        
+        for (int row = range.firstRow; row <= range.lastRow; row++)
+        {
+            for (int col = range.firstCol; col <= range.lastCol; col++)
+            {
+                queueChunkCells(row * gChunkCols + col);
+            }
+        }
+        
+        if (gHintCellIndex >= 0)
+        {
+            queueCellHint(gHintCellIndex);
+        }
+        
+        if (gHoveredCellIndex >= 0)
+        {
+            queueCellHover(gHoveredCellIndex);
+        }
+        
+        flushCells();
+        clearDirtyCells();
+    }
+    else
+    {
+        for (int row = range.firstRow; row <= range.lastRow; row++)
+        {
+            for (int col = range.firstCol; col <= range.lastCol; col++)
+            {
+                int chunkIndex = row * gChunkCols + col;
+                SDL_Rect chunkRect = getChunkScreenRect(chunkIndex);
+                PROFILE_COUNT("render calls", 1);
+                SDL_RenderCopy(gCurrentRenderer, gChunks[chunkIndex].texture, nullptr, &chunkRect);
+            }
+        }
+    }
+    
+    SDL_RenderSetClipRect(gCurrentRenderer, nullptr);
+}
+
+static void updateHoveredCell()
+{
+    int hoveredCellIndex = -1;
+    
+    if (mouseIsTouchingCell())
+    {
+        hoveredCellIndex = getCellIndexAtPosition(gMousePosition);
+    }
+    
+    if (hoveredCellIndex != gHoveredCellIndex ||
+        gMouseMode != gHoveredMouseMode)
+    {
+        markCellDirty(gHoveredCellIndex);
+        markCellDirty(hoveredCellIndex);
+        gHoveredCellIndex = hoveredCellIndex;
+        gHoveredMouseMode = gMouseMode;
+    }
+}
+
+// Brings every visible chunk up to date: chunks that are new or stale get
+// drawn whole, the rest only get their dirty cells.  Dirty cells in chunks
+// that aren't visible just mark the chunk stale.
+static void patchBoardChunks(ChunkRange range)
+{
+    double chunkScale = std::min(gViewport.zoom, 1.0);
+    
+    if (chunkScale != gChunkScale)
+    {
+        destroyChunkTextures();
+        gChunkScale = chunkScale;
+    }
+    
+    gRenderFrame++;
+    
+    // Marked first so making room for a new texture never throws out one
+    // that's about to be drawn.
+    for (int row = range.firstRow; row <= range.lastRow; row++)
+    {
+        for (int col = range.firstCol; col <= range.lastCol; col++)
+        {
+            gChunks[row * gChunkCols + col].lastDrawnFrame = gRenderFrame;
+        }
+    }
+    
+    // Sorted by chunk so each chunk is a render target once, in the same
+    // order the visible chunks are walked.
+    std::sort(gDirtyCells.begin(), gDirtyCells.end(), [](int a, int b) {
+        return getChunkIndexForCell(a) < getChunkIndexForCell(b);
+    });
+    
+    int dirtyIndex = 0;
+    bool drewChunks = false;
+    
+    for (int row = range.firstRow; row <= range.lastRow && gChunkTexturesSupported; row++)
+    {
+        for (int col = range.firstCol; col <= range.lastCol && gChunkTexturesSupported; col++)
+        {
+            int chunkIndex = row * gChunkCols + col;
+            dirtyIndex = skipDirtyCellsBefore(chunkIndex, dirtyIndex);
+            
+            int firstDirty = dirtyIndex;
+            
+            while (dirtyIndex < gDirtyCells.size() &&
+                   getChunkIndexForCell(gDirtyCells[dirtyIndex]) == chunkIndex)
+            {
+                dirtyIndex++;
+            }
+            
+            if (gChunks[chunkIndex].texture == nullptr && !createChunkTexture(chunkIndex))
+            {
+                break;
+            }
+            
+            drewChunks = drawChunk(chunkIndex, firstDirty, dirtyIndex) || drewChunks;
+        }
+    }
+    
+    skipDirtyCellsBefore(gChunkCols * gChunkRows, dirtyIndex);
+    
+    if (drewChunks)
+    {
+        SDL_SetRenderTarget(gCurrentRenderer, nullptr);
+    }
+    
+    clearDirtyCells();
+}
+
+// Dirty cells from dirtyIndex on that come before chunkIndex are in chunks
+// that aren't on screen.  Returns where chunkIndex's cells start.
+static int skipDirtyCellsBefore(int chunkIndex, int dirtyIndex)
+{
+    while (dirtyIndex < gDirtyCells.size())
+    {
+        int dirtyChunkIndex = getChunkIndexForCell(gDirtyCells[dirtyIndex]);
+        
+        if (dirtyChunkIndex >= chunkIndex)
+        {
+            break;
+        }
+        
+        gChunks[dirtyChunkIndex].needsFullRedraw = true;
+        dirtyIndex++;
+    }
+    
+    return dirtyIndex;
+}
+
+// Redraws the chunk if it's stale, otherwise gDirtyCells[firstDirty] up to
+// lastDirty, which all belong to it.  False if there was nothing to draw.
+static bool drawChunk(int chunkIndex, int firstDirty, int lastDirty)
+{
+    BoardChunk &chunk = gChunks[chunkIndex];
+    
+    if (!chunk.needsFullRedraw && firstDirty == lastDirty)
+    {
+        return false;
+    }
+    
+    SDL_SetRenderTarget(gCurrentRenderer, chunk.texture);
+    setCellTransformForChunk(chunkIndex);
+    
+    if (chunk.needsFullRedraw)
+    {
+        SDL_SetRenderDrawColor(gCurrentRenderer, 0, 0, 0, 255);
+        PROFILE_COUNT("render calls", 1);
+        SDL_RenderClear(gCurrentRenderer);
+        queueChunkCells(chunkIndex);
+    }
+    else
+    {
+        for (int dirtyIndex = firstDirty; dirtyIndex < lastDirty; dirtyIndex++)
+        {
+            queueCell(gDirtyCells[dirtyIndex]);
+        }
+    }
+    
+    // The overlays are blended, so they only go on top of a freshly drawn cell.
+    if (gHintCellIndex >= 0 &&
+        getChunkIndexForCell(gHintCellIndex) == chunkIndex &&
+        (chunk.needsFullRedraw || gCellIsDirty[gHintCellIndex]))
+    {
+        queueCellHint(gHintCellIndex);
+    }
+    
+    if (gHoveredCellIndex >= 0 &&
+        getChunkIndexForCell(gHoveredCellIndex) == chunkIndex &&
+        (chunk.needsFullRedraw || gCellIsDirty[gHoveredCellIndex]))
+    {
+        queueCellHover(gHoveredCellIndex);
+    }
+    
+    flushCells();
+    chunk.needsFullRedraw = false;
+    
+    return true;
+}
+
+static void queueChunkCells(int chunkIndex)
+{
+    const Board &board = gGame.board;
+    int firstX = chunkIndex % gChunkCols * CHUNK_CELLS;
+    int firstY = chunkIndex / gChunkCols * CHUNK_CELLS;
+    int lastX = std::min(firstX + CHUNK_CELLS, board.width);
+    int lastY = std::min(firstY + CHUNK_CELLS, board.height);
+    
+    for (int y = firstY; y < lastY; y++)
+    {
+        for (int x = firstX; x < lastX; x++)
+        {
+            queueCell(getCellIndex(board, x, y));
+        }
+    }
+}
+
+// Makes room in the cache first.  False when the renderer won't make one,
+// in which case the board is drawn without chunk textures from then on.
+static bool createChunkTexture(int chunkIndex)
+{
+    BoardChunk &chunk = gChunks[chunkIndex];
+    int nCols = std::min(CHUNK_CELLS, gGame.board.width - chunkIndex % gChunkCols * CHUNK_CELLS);
+    int nRows = std::min(CHUNK_CELLS, gGame.board.height - chunkIndex / gChunkCols * CHUNK_CELLS);
+    int width = nCols * (int)(CELL_WIDTH * gChunkScale);
+    int height = nRows * (int)(CELL_HEIGHT * gChunkScale);
+    size_t textureBytes = (size_t)width * height * 4;
+    
+    evictChunkTextures(textureBytes);
+    
+    PROFILE_COUNT("textures created", 1);
+    chunk.texture = SDL_CreateTexture(gCurrentRenderer,
+                                      SDL_PIXELFORMAT_ARGB8888,
+                                      SDL_TEXTUREACCESS_TARGET,
+                                      width,
+                                      height);
+    
+    if (chunk.texture == nullptr)
+    {
+        std::cout << "Unable to create board chunk texture" << std::endl;
+        std::cout << SDL_GetError() << std::endl;
+        gChunkTexturesSupported = false;
+        destroyChunkTextures();
+        return false;
+    }
+    
+    SDL_SetTextureBlendMode(chunk.texture, SDL_BLENDMODE_NONE);
+    chunk.textureBytes = textureBytes;
+    chunk.needsFullRedraw = true;
+    gChunksWithTextures.push_back(chunkIndex);
+    gChunkTextureBytes += textureBytes;
+    
+    return true;
+}
+
+// Throws out the least recently drawn chunks until neededBytes more fits
+// in CHUNK_TEXTURE_BUDGET.  Chunks on screen this frame are kept even if
+// that means going over.
+static void evictChunkTextures(size_t neededBytes)
+{
+    while (gChunkTextureBytes + neededBytes > CHUNK_TEXTURE_BUDGET)
+    {
+        int oldestIndex = -1;
+        
+        for (int textureIndex = 0;
+             textureIndex < gChunksWithTextures.size();
+             textureIndex++)
+        {
+            const BoardChunk &chunk = gChunks[gChunksWithTextures[textureIndex]];
+            
+            if (chunk.lastDrawnFrame != gRenderFrame &&
+                (oldestIndex < 0 ||
+                 chunk.lastDrawnFrame < gChunks[gChunksWithTextures[oldestIndex]].lastDrawnFrame))
+            {
+                oldestIndex = textureIndex;
+            }
+        }
+        
+        if (oldestIndex < 0)
+        {
+            return;
+        }
+        
+        BoardChunk &chunk = gChunks[gChunksWithTextures[oldestIndex]];
+        SDL_DestroyTexture(chunk.texture);
+        chunk.texture = nullptr;
+        gChunkTextureBytes -= chunk.textureBytes;
+        
+        gChunksWithTextures[oldestIndex] = gChunksWithTextures.back();
+        gChunksWithTextures.pop_back();
+    }
+}
+
+static void destroyChunkTextures()
+{
+    for (int textureIndex = 0;
+         textureIndex < gChunksWithTextures.size();
+         textureIndex++)
+    {
+        BoardChunk &chunk = gChunks[gChunksWithTextures[textureIndex]];
+        SDL_DestroyTexture(chunk.texture);
+        chunk.texture = nullptr;
+    }
+    
+    gChunksWithTextures.clear();
+    gChunkTextureBytes = 0;
+}
+
+static int getChunkIndexForCell(int cellIndex)
+{
+    return getCellY(gGame.board, cellIndex) / CHUNK_CELLS * gChunkCols +
+           getCellX(gGame.board, cellIndex) / CHUNK_CELLS;
+}
+
+static ChunkRange getVisibleChunks()
+{
+    double chunkWidth = CHUNK_CELLS * CELL_WIDTH;
+    double chunkHeight = CHUNK_CELLS * CELL_HEIGHT;
+    double left = std::max(gViewport.x, 0.0);
+    double top = std::max(gViewport.y, 0.0);
+    double right = std::min(getBoardX(gViewport, gViewport.width), (double)gViewport.boardWidth);
+    double bottom = std::min(getBoardY(gViewport, gViewport.height), (double)gViewport.boardHeight);
+    
+    ChunkRange range = {
+        std::max((int)(left / chunkWidth), 0),
+        std::min((int)ceil(right / chunkWidth) - 1, gChunkCols - 1),
+        std::max((int)(top / chunkHeight), 0),
+        std::min((int)ceil(bottom / chunkHeight) - 1, gChunkRows - 1)
+    };
+    
+    return range;
+}
+
+// Where the chunk's texture goes in the window.  Both edges are rounded the
+// same way so neighbouring chunks meet without a gap.
+static SDL_Rect getChunkScreenRect(int chunkIndex)
+{
+    int firstX = chunkIndex % gChunkCols * CHUNK_CELLS;
+    int firstY = chunkIndex / gChunkCols * CHUNK_CELLS;
+    int lastX = std::min(firstX + CHUNK_CELLS, gGame.board.width);
+    int lastY = std::min(firstY + CHUNK_CELLS, gGame.board.height);
+    int left = getScreenX(gViewport, firstX * CELL_WIDTH);
+    int top = getScreenY(gViewport, firstY * CELL_HEIGHT);
+    
+    SDL_Rect rect = {
+        left,
+        top + GAME_HEADER_OFFSET,
+        getScreenX(gViewport, lastX * CELL_WIDTH) - left,
+        getScreenY(gViewport, lastY * CELL_HEIGHT) - top
+    };
+    
+    return rect;
+}
+
+static void setCellTransformForChunk(int chunkIndex)
+{
+    int cellWidth = (int)(CELL_WIDTH * gChunkScale);
+    int cellHeight = (int)(CELL_HEIGHT * gChunkScale);
+    
+    gCellTransform = {
+        chunkIndex % gChunkCols * CHUNK_CELLS * cellWidth,
+        chunkIndex / gChunkCols * CHUNK_CELLS * cellHeight,
+        cellWidth,
+        cellHeight
+    };
+}
+
+// Cells straight into the window, for when there are no chunk textures.
+static void setCellTransformForScreen()
+{
+    gCellTransform = {
+        (int)floor(gViewport.x * gViewport.zoom),
+        (int)floor(gViewport.y * gViewport.zoom) - GAME_HEADER_OFFSET,
+        (int)(CELL_WIDTH * gViewport.zoom),
+        (int)(CELL_HEIGHT * gViewport.zoom)
+    };
+}
+
+static void clearDirtyCells()
+{
+    for (int dirtyIndex = 0;
+         dirtyIndex < gDirtyCells.size();
+         dirtyIndex++)
+    {
+        gCellIsDirty[gDirtyCells[dirtyIndex]] = false;
+    }
+    
+    gDirtyCells.clear();
+}
+
+// dx and dy in screen pixels.
+static void panBoard(int dx, int dy)
+{
+    if (gState != GameState_Launcher)
+    {
+        panViewport(gViewport, dx, dy);
+    }
+}
+
+// Zooms around position, in window coordinates.
+static void zoomBoard(double factor, Vector2i position)
+{
+    if (gState != GameState_Launcher)
+    {
+        zoomViewport(gViewport, factor, position.x, position.y - GAME_HEADER_OFFSET);
+    }
+}
+
+static void renderCellHover(int cellIndex)
+{
+    SDL_Rect mouseRect = getCellRect(cellIndex);
+    SDL_Color mrc = getHoverColor();
+    SDL_SetRenderDrawColor(gCurrentRenderer, mrc.r, mrc.g, mrc.b, mrc.a);
+    PROFILE_COUNT("render calls", 1);
+    SDL_RenderFillRect(gCurrentRenderer, &mouseRect);
+}
+
+static void renderCellHint(int cellIndex)
+{
+    SDL_Rect hintRect = getCellRect(cellIndex);
+    SDL_Color hintColor = HINT_COLOR;
+    SDL_SetRenderDrawColor(gCurrentRenderer, hintColor.r, hintColor.g, hintColor.b, hintColor.a);
+    PROFILE_COUNT("render calls", 1);
+    SDL_RenderFillRect(gCurrentRenderer, &hintRect);
+}
+
+static void renderCellProbability(int cellIndex)
+{
+    SDL_Rect rect = getCellRect(cellIndex);
+    SDL_Color color = getProbabilityColor(getProbabilityShade(cellIndex));
+    SDL_SetRenderDrawColor(gCurrentRenderer, color.r, color.g, color.b, color.a);
+    PROFILE_COUNT("render calls", 1);
+    SDL_RenderFillRect(gCurrentRenderer, &rect);
+}
+
+// Probabilities are rounded to a few shades so the batch stays a handful
+// of draw calls.
+static int getProbabilityShade(int cellIndex)
+{
+    float probability = getMineProbability(gProbabilityMap, gSolver, gGame.board, cellIndex);
+    return (int)(probability * (PROBABILITY_SHADES - 1) + 0.5f);
+}
+
+static SDL_Color getProbabilityColor(int shade)
+{
+    // Green for safe through to red for a mine.
+    int red = 255 * shade / (PROBABILITY_SHADES - 1);
+    SDL_Color color = { (Uint8)red, (Uint8)(255 - red), 0, 95 };
+    return color;
+}
+
+static SDL_Color getHoverColor()
+{
+    // Mouse Rect Color.  Laziness.
+    SDL_Color mrc = { 255, 255, 0, 63 };
+    if (gMouseMode == MouseMode_ClearMode) {
+        mrc = { 255, 0, 0, 63 };
+    }
+    return mrc;
+}
+
+// Draws the cell right away, or holds on to it until flushCells when
+// batching is on.
+static void queueCell(int cellIndex)
+{
+    bool showProbability = gShowProbabilities && !cellIsOpen(gGame.board, cellIndex);
+    
+    if (gBatchedRendering)
+    {
+        addCellToBatch(gCellBatch, cellIndex);
+        
+        if (showProbability)
+        {
+            gCellBatch.probabilityRects[getProbabilityShade(cellIndex)].push_back(getCellRect(cellIndex));
+        }
+    }
+    else
+    {
+        renderCell(cellIndex);
+        
+        if (showProbability)
+        {
+            renderCellProbability(cellIndex);
+        }
+    }
+}
+
+static void queueCellHover(int cellIndex)
+{
+    if (gBatchedRendering)
+    {
+        gCellBatch.hoverRects.push_back(getCellRect(cellIndex));
+    }
+    else
+    {
+        renderCellHover(cellIndex);
+    }
+}
+
+static void queueCellHint(int cellIndex)
+{
+    if (gBatchedRendering)
+    {
+        gCellBatch.hintRects.push_back(getCellRect(cellIndex));
+    }
+    else
+    {
+        renderCellHint(cellIndex);
+    }
+}
+
+static void flushCells()
+{
+    if (gBatchedRendering)
+    {
+        renderCellBatch(gCellBatch);
+        clearCellBatch(gCellBatch);
+    }
+}
+
+static void addCellToBatch(CellBatch &batch, int cellIndex)
+{
+    SDL_Rect rect = getCellRect(cellIndex);
+    
+    if (!cellIsOpen(gGame.board, cellIndex))
+    {
+        batch.closedRects.push_back(rect);
+        
+        if (cellHasFlag(gGame.board, cellIndex))
+        {
+            batch.flagRects.push_back(getFlagRect(cellIndex));
+        }
+    }
+    else
+    {
+        batch.openRects.push_back(rect);
+        
+        if (cellHasMine(gGame.board, cellIndex) || getAdjacentMines(gGame.board, cellIndex) > 0)
+        {
+            batch.textCells.push_back(cellIndex);
         }
-            break;
-            
-        default:
-            break;
     }
-    
-    SDL_RenderPresent(gCurrentRenderer);
 }
 
-static void renderLauncher()
+static void renderRects(const std::vector<SDL_Rect> &rects, SDL_Color color)
 {
-    for (int buttonIndex = 0;
-         buttonIndex < launcherButtons.size();
-         buttonIndex++)
+    if (rects.empty())
     {
-        renderButton(launcherButtons[buttonIndex]);
+        return;
     }
+    
+    SDL_SetRenderDrawColor(gCurrentRenderer, color.r, color.g, color.b, color.a);
+    PROFILE_COUNT("render calls", 1);
+    SDL_RenderFillRects(gCurrentRenderer, rects.data(), (int)rects.size());
 }
 
-static void renderGame()
+static void renderCellBatch(const CellBatch &batch)
 {
-    for (int buttonIndex = 0;
-         buttonIndex < gameButtons.size();
-         buttonIndex++)
+    // One draw call per color instead of one per cell.  Order matters:
+    // flags sit on closed cells, numbers on open cells, then the hint and
+    // hover on top.
+    renderRects(batch.closedRects, { 100, 100, 100, 255 });
+    renderRects(batch.openRects, { 200, 200, 200, 255 });
+    renderRects(batch.flagRects, { 255, 255, 0, 255 });
+    
+    for (int textIndex = 0;
+         textIndex < batch.textCells.size();
+         textIndex++)
     {
-        renderButton(gameButtons[buttonIndex]);
+        renderCellText(batch.textCells[textIndex]);
     }
     
-    for (int cellIndex = 0;
-         cellIndex < gameCells.size();
-         cellIndex++)
+    for (int shade = 0; shade < PROBABILITY_SHADES; shade++)
     {
-        renderCell(gameCells[cellIndex]);
+        renderRects(batch.probabilityRects[shade], getProbabilityColor(shade));
     }
     
-    if (mouseIsTouchingCell())
+    renderRects(batch.hintRects, HINT_COLOR);
+    renderRects(batch.hoverRects, getHoverColor());
+}
+
+static void clearCellBatch(CellBatch &batch)
+{
+    // clear() keeps the capacity around for the next frame.
+    batch.closedRects.clear();
+    batch.openRects.clear();
+    batch.flagRects.clear();
+    batch.hintRects.clear();
+    batch.hoverRects.clear();
+    
+    for (int shade = 0; shade < PROBABILITY_SHADES; shade++)
     {
-        SDL_Rect mouseRect = {
-            (gMousePosition.x / CELL_WIDTH) * CELL_WIDTH,
-            (gMousePosition.y / CELL_HEIGHT) * CELL_HEIGHT,
-            CELL_WIDTH,
-            CELL_HEIGHT
-        };
-        // Mouse Rect Color.  Laziness.
-        SDL_Color mrc = { 255, 255, 0 };
-        if (gMouseMode == MouseMode_ClearMode) {
-            mrc = { 255, 0, 0 };
-        }
-        SDL_SetRenderDrawColor(gCurrentRenderer, mrc.r, mrc.g, mrc.b, 63);
-        SDL_RenderFillRect(gCurrentRenderer, &mouseRect);
+        batch.probabilityRects[shade].clear();
+    }
+
+    batch.textCells.clear();
+}
+
+static void markCellDirty(int cellIndex)
+{
+    if (cellIndex < 0 || gCellIsDirty[cellIndex])
+    {
+        return;
+    }
+    
+    gCellIsDirty[cellIndex] = true;
+    gDirtyCells.push_back(cellIndex);
+}
+
+static void markBoardDirty()
+{
+    for (int chunkIndex = 0;
+         chunkIndex < gChunks.size();
+         chunkIndex++)
+    {
+        gChunks[chunkIndex].needsFullRedraw = true;
     }
 }
 
+// Relative to whatever is being drawn into, see gCellTransform.
+static Vector2i getCellPosition(int cellIndex)
+{
+    Vector2i position = {
+        getCellX(gGame.board, cellIndex) * gCellTransform.cellWidth - gCellTransform.originX,
+        getCellY(gGame.board, cellIndex) * gCellTransform.cellHeight - gCellTransform.originY
+    };
+    
+    return position;
+}
+
+static SDL_Rect getCellRect(int cellIndex)
+{
+    Vector2i position = getCellPosition(cellIndex);
+    
+    SDL_Rect rect = {
+        position.x,
+        position.y,
+        gCellTransform.cellWidth,
+        gCellTransform.cellHeight
+    };
+    
+    return rect;
+}
+
 static void renderButton(Button button)
 {
     SDL_Rect rect = {
@@ -720,6 +2238,7 @@ static void renderButton(Button button)
             break;
     }
     
+    PROFILE_COUNT("render calls", 1);
     SDL_RenderFillRect(gCurrentRenderer, &rect);
     renderText(button.text, {
         button.position.x + button.size.x / 2,
@@ -729,119 +2248,147 @@ static void renderButton(Button button)
 
 static void renderText(const char *text, Vector2i position, SDL_Color color)
 {
-    // Super inefficient, but it will do for now.
-    SDL_Surface *fontSurface = TTF_RenderText_Blended(gDefaultFont, text, color);
+    PROFILE_SCOPE("renderText");
+    const TextAtlasEntry &entry = getTextAtlasEntry(gTextAtlas,
+                                                    gDefaultFont,
+                                                    text,
+                                                    color);
     
-    if (fontSurface == nullptr)
-    {
-        std::cout << "Unable to render font" << std::endl;
-        std::cout << TTF_GetError() << std::endl;
-        SDL_Quit();
-        TTF_Quit();
-        exit(1);
-    }
+    SDL_Rect destRect = {
+        position.x - entry.rect.w / 2,
+        position.y - entry.rect.h / 2,
+        entry.rect.w,
+        entry.rect.h
+    };
     
-    SDL_Texture *fontTexture = SDL_CreateTextureFromSurface(gCurrentRenderer,
-                                                            fontSurface);
+    PROFILE_COUNT("render calls", 1);
+    SDL_RenderCopy(gCurrentRenderer, entry.texture, &entry.rect, &destRect);
+}
+
+// Left-aligned, one character at a time.  Text that changes every frame
+// would fill the atlas with one-off strings, single characters don't.
+static void renderTextLeft(const char *text, Vector2i position, SDL_Color color)
+{
+    char character[2] = { 0, 0 };
+    int x = position.x;
     
-    if (fontTexture == nullptr)
+    for (const char *c = text; *c != '\0'; c++)
     {
-        std::cout << "Unable to render font" << std::endl;
-        std::cout << TTF_GetError() << std::endl;
-        SDL_Quit();
-        TTF_Quit();
-        exit(1);
+        character[0] = *c;
+        
+        const TextAtlasEntry &entry = getTextAtlasEntry(gTextAtlas,
+                                                        gDefaultFont,
+                                                        *c == ' ' ? "_" : character,
+                                                        color);
+        
+        if (*c != ' ')
+        {
+            SDL_Rect destRect = {
+                x,
+                position.y,
+                entry.rect.w,
+                entry.rect.h
+            };
+            
+            PROFILE_COUNT("render calls", 1);
+            SDL_RenderCopy(gCurrentRenderer, entry.texture, &entry.rect, &destRect);
+        }
+        
+        x += entry.rect.w;
     }
+}
+
+static void logTextAtlasStats(const TextAtlas &atlas)
+{
+    TextAtlasStats stats = getTextAtlasStats(atlas);
     
-    SDL_Rect srcRect = {
-        0,
-        0,
-        0,
-        0
-    };
+    std::cout << "Text atlas: "
+              << stats.hits << " hits, "
+              << stats.misses << " misses, "
+              << stats.texturesCreated << " textures created" << std::endl;
+}
+
+static void renderCell(int cellIndex)
+{
+    SDL_Rect rect = getCellRect(cellIndex);
     
-    SDL_QueryTexture(fontTexture, nullptr, nullptr, &srcRect.w, &srcRect.h);
+    if (!cellIsOpen(gGame.board, cellIndex))
+    {
+        SDL_SetRenderDrawColor(gCurrentRenderer, 100, 100, 100, 255);
+        PROFILE_COUNT("render calls", 1);
+        SDL_RenderFillRect(gCurrentRenderer, &rect);
+        
+        if (cellHasFlag(gGame.board, cellIndex))
+        {
+            SDL_Rect flagRect = getFlagRect(cellIndex);
+            
+            SDL_SetRenderDrawColor(gCurrentRenderer, 255, 255, 0, 255);
+            PROFILE_COUNT("render calls", 1);
+            SDL_RenderFillRect(gCurrentRenderer, &flagRect);
+        }
+    }
+    else
+    {
+        SDL_SetRenderDrawColor(gCurrentRenderer, 200, 200, 200, 255);
+        PROFILE_COUNT("render calls", 1);
+        SDL_RenderFillRect(gCurrentRenderer, &rect);
+        
+        if (cellHasMine(gGame.board, cellIndex) || getAdjacentMines(gGame.board, cellIndex) > 0)
+        {
+            renderCellText(cellIndex);
+        }
+    }
+}
+
+static void renderCellText(int cellIndex)
+{
+    std::string adjMinesString;
+    int adjMineCount;
     
-    SDL_Rect destRect = {
-        position.x - srcRect.w / 2,
-        position.y - srcRect.h / 2,
-        srcRect.w,
-        srcRect.h
-    };
+    if (!cellHasMine(gGame.board, cellIndex))
+    {
+        adjMineCount = getAdjacentMines(gGame.board, cellIndex);
+        adjMinesString = std::to_string(adjMineCount);
+    }
+    else
+    {
+        adjMinesString = "B";
+        adjMineCount = ADJ_MINE_BOMB;
+    }
     
-    SDL_RenderCopy(gCurrentRenderer, fontTexture, &srcRect, &destRect);
+    Vector2i position = getCellPosition(cellIndex);
+    SDL_Color color = getColorForAdjacentMineCount(adjMineCount);
     
-    SDL_FreeSurface(fontSurface);
-    SDL_DestroyTexture(fontTexture);
+    if (gCellTransform.cellWidth < CELL_WIDTH)
+    {
+        // Zoomed out too far for the font, a dot in the number's color.
+        SDL_Rect dotRect = getFlagRect(cellIndex);
+        SDL_SetRenderDrawColor(gCurrentRenderer, color.r, color.g, color.b, 255);
+        PROFILE_COUNT("render calls", 1);
+        SDL_RenderFillRect(gCurrentRenderer, &dotRect);
+        return;
+    }
     
-    fontSurface = nullptr;
-    fontTexture = nullptr;
+    renderText(adjMinesString.c_str(), {
+        position.x + gCellTransform.cellWidth / 2,
+        position.y + gCellTransform.cellHeight / 2
+    }, color);
 }
 
-static void renderCell(Cell cell)
+static SDL_Rect getFlagRect(int cellIndex)
 {
-    std::string adjMinesString;
-    
-    SDL_Rect rect = {
-        cell.position.x,
-        cell.position.y,
-        CELL_WIDTH,
-        CELL_HEIGHT
+    Vector2i position = getCellPosition(cellIndex);
+    int flagWidth = gCellTransform.cellWidth / 2;
+    int flagHeight = gCellTransform.cellHeight / 2;
+    
+    SDL_Rect flagRect = {
+        position.x + gCellTransform.cellWidth / 2 - flagWidth / 2,
+        position.y + gCellTransform.cellHeight / 2 - flagHeight / 2,
+        flagWidth,
+        flagHeight
     };
     
-    switch (cell.state)
-    {
-        case CellState_Closed:
-            SDL_SetRenderDrawColor(gCurrentRenderer, 100, 100, 100, 255);
-            SDL_RenderFillRect(gCurrentRenderer, &rect);
-            
-            if (cell.hasFlag)
-            {
-                int flagWidth = CELL_WIDTH / 2;
-                int flagHeight = CELL_HEIGHT / 2;
-                
-                SDL_Rect flagRect = {
-                    cell.position.x + CELL_WIDTH / 2 - flagWidth / 2,
-                    cell.position.y + CELL_HEIGHT / 2 - flagHeight / 2,
-                    flagWidth,
-                    flagHeight
-                };
-                
-                SDL_SetRenderDrawColor(gCurrentRenderer, 255, 255, 0, 255);
-                SDL_RenderFillRect(gCurrentRenderer, &flagRect);
-            }
-            break;
-            
-        case CellState_Open:
-            SDL_SetRenderDrawColor(gCurrentRenderer, 200, 200, 200, 255);
-            if (!cell.hasMine)
-            {
-                adjMinesString = std::to_string(cell.adjacentMines);
-                
-                SDL_RenderFillRect(gCurrentRenderer, &rect);
-                
-                if (cell.adjacentMines > 0)
-                {
-                    renderText(adjMinesString.c_str(), {
-                        cell.position.x + CELL_WIDTH / 2,
-                        cell.position.y + CELL_HEIGHT / 2
-                    }, getColorForAdjacentMineCount(cell.adjacentMines));
-                }
-            }
-            else
-            {
-                adjMinesString = "B";
-                SDL_RenderFillRect(gCurrentRenderer, &rect);
-                renderText(adjMinesString.c_str(), {
-                    cell.position.x + CELL_WIDTH / 2,
-                    cell.position.y + CELL_HEIGHT / 2
-                }, getColorForAdjacentMineCount(ADJ_MINE_BOMB));
-            }
-            break;
-            
-        default:
-            break;
-    }
+    return flagRect;
 }
 
 static bool mouseOverButton(Button button)
@@ -942,14 +2489,25 @@ static void setDifficulty(Difficulty difficulty)
     }
 }
 
-static Cell &getCellAtPosition(Vector2i position)
+static int getCellIndexAtPosition(Vector2i position)
 {
+    if (position.x < 0 || position.x >= gViewport.width ||
+        position.y < GAME_HEADER_OFFSET || position.y >= GAME_HEADER_OFFSET + gViewport.height)
+    {
+        return -1;
+    }
+    
     Vector2i cellIndex2d = {
-        position.x / CELL_WIDTH,
-        (position.y - GAME_HEADER_OFFSET) / CELL_HEIGHT
+        (int)floor(getBoardX(gViewport, position.x) / CELL_WIDTH),
+        (int)floor(getBoardY(gViewport, position.y - GAME_HEADER_OFFSET) / CELL_HEIGHT)
     };
     
-    return getCellAtBlockPosition(cellIndex2d);
+    if (!isInsideBoard(gGame.board, cellIndex2d.x, cellIndex2d.y))
+    {
+        return -1;
+    }
+    
+    return get1dIndexFor2dIndex(cellIndex2d, { gGame.board.width, gGame.board.height });
 }
 
 static int get1dIndexFor2dIndex(Vector2i index2d, Vector2i arraySize)
@@ -959,53 +2517,7 @@ static int get1dIndexFor2dIndex(Vector2i index2d, Vector2i arraySize)
 
 static bool mouseIsTouchingCell()
 {
-    SDL_Rect mouseRect = {
-        gMousePosition.x,
-        gMousePosition.y,
-        1,
-        1
-    };
-    
-    SDL_Rect cellFieldRect = {
-        0,
-        GAME_HEADER_OFFSET,
-        gDifficulty.nCols * CELL_WIDTH,
-        gDifficulty.nRows * CELL_HEIGHT
-    };
-    
-    return SDL_HasIntersection(&mouseRect, &cellFieldRect);
-}
-
-static void putMinesInNRandomCells(int nCells)
-{
-    if (nCells > gameCells.size())
-    {
-        nCells = (int)gameCells.size();
-    }
-    
-    for (int cellIndex = 0;
-         cellIndex < nCells;
-         cellIndex++)
-    {
-        int randomIndex = random(0, (int)gameCells.size());
-        
-        while (gameCells[randomIndex].hasMine)
-        {
-            randomIndex = random(0, (int)gameCells.size());
-        }
-        
-        gameCells[randomIndex].hasMine = true;
-        gameCells[randomIndex].adjacentMines = -1;
-    }
-}
-
-static int random(int min, int max)
-{
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(min, max - 1);
-    
-    return dis(gen);
+    return getCellIndexAtPosition(gMousePosition) >= 0;
 }
 
 static SDL_Color getColorForAdjacentMineCount(int adjMineCount)
@@ -1055,123 +2567,165 @@ static SDL_Color getColorForAdjacentMineCount(int adjMineCount)
     return { 0, 0, 0 };
 }
 
-static void loseGame()
-{
-    std::cout << "You lost" << std::endl;
-    revealMines();
-    
-    gState = GameState_Lost;
-}
-
-static void revealMines()
+static void sendGameCommand(Command command)
 {
-    for (int cellIndex = 0;
-         cellIndex < gameCells.size();
-         cellIndex++)
+    if (gRecordingGame)
     {
-        if (gameCells[cellIndex].hasMine)
-        {
-            gameCells[cellIndex].state = CellState_Open;
-        }
+        recordCommand(gRecorder, (uint32_t)gGameUpdates, command);
     }
-}
-
-static void assignAdjacentMineCounts(Cell &rootCell)
-{
-    if (rootCell.hasMine)
+    
+    if (command.type == CommandType_Reveal && gGameNoGuess && !gGame.minesPlaced &&
+        !cellHasFlag(gGame.board, command.cellIndex))
     {
-        return;
+        // How long the search takes shows in the F4 profile.
+        PROFILE_SCOPE("placeNoGuessMines");
+        placeNoGuessMines(gGame, command.cellIndex, &gWorkPool, nullptr);
     }
     
-    Vector2i rcPos = {
-        rootCell.position.x / CELL_WIDTH,
-        (rootCell.position.y - GAME_HEADER_OFFSET) / CELL_HEIGHT
-    };
+    applyCommand(gGame, command, gGameDelta);
     
-    bool tL = getCellAtBlockPosition({ rcPos.x - 1, rcPos.y - 1 }).hasMine;
-    bool tC = getCellAtBlockPosition({ rcPos.x, rcPos.y - 1 }).hasMine;
-    bool tR = getCellAtBlockPosition({ rcPos.x + 1, rcPos.y - 1 }).hasMine;
-    bool cL = getCellAtBlockPosition({ rcPos.x - 1, rcPos.y }).hasMine;
-    bool cR = getCellAtBlockPosition({ rcPos.x + 1, rcPos.y }).hasMine;
-    bool bL = getCellAtBlockPosition({ rcPos.x - 1, rcPos.y + 1 }).hasMine;
-    bool bC = getCellAtBlockPosition({ rcPos.x, rcPos.y + 1 }).hasMine;
-    bool bR = getCellAtBlockPosition({ rcPos.x + 1, rcPos.y + 1 }).hasMine;
+    for (int changedIndex = 0;
+         changedIndex < gGameDelta.changedCells.size();
+         changedIndex++)
+    {
+        markCellDirty(gGameDelta.changedCells[changedIndex]);
+    }
     
-    if (tL) rootCell.adjacentMines++;
-    if (tC) rootCell.adjacentMines++;
-    if (tR) rootCell.adjacentMines++;
-    if (cL) rootCell.adjacentMines++;
-    if (cR) rootCell.adjacentMines++;
-    if (bL) rootCell.adjacentMines++;
-    if (bC) rootCell.adjacentMines++;
-    if (bR) rootCell.adjacentMines++;
-}
-
-static void uncoverPartOfBoard(Cell &rootCell)
-{
-    uncoveredCells++;
-    rootCell.state = CellState_Open;
+    updateSolver(gSolver, gGame.board, gGameDelta.changedCells);
     
-    if (rootCell.adjacentMines != 0)
+    if (gShowProbabilities && !gGameDelta.changedCells.empty())
     {
-        return;
+        updateProbabilities();
+        // Any closed cell's odds can move, not just the ones next to the change.
+        markBoardDirty();
     }
     
-    Vector2i rcPos = {
-        rootCell.position.x / CELL_WIDTH,
-        (rootCell.position.y - GAME_HEADER_OFFSET) / CELL_HEIGHT
-    };
+    if (gHintCellIndex >= 0 && cellIsOpen(gGame.board, gHintCellIndex))
+    {
+        gHintCellIndex = -1;
+    }
+    
+    switch (gGameDelta.status)
+    {
+        case GameStatus_Lost:
+            std::cout << "You lost" << std::endl;
+            gState = GameState_Lost;
+            break;
+            
+        case GameStatus_Won:
+            gState = GameState_Win;
+            break;
+            
+        default:
+            break;
+    }
     
-    Cell &tL = getCellAtBlockPosition({ rcPos.x - 1, rcPos.y - 1 });
-    Cell &tC = getCellAtBlockPosition({ rcPos.x, rcPos.y - 1 });
-    Cell &tR = getCellAtBlockPosition({ rcPos.x + 1, rcPos.y - 1 });
-    Cell &cL = getCellAtBlockPosition({ rcPos.x - 1, rcPos.y });
-    Cell &cR = getCellAtBlockPosition({ rcPos.x + 1, rcPos.y });
-    Cell &bL = getCellAtBlockPosition({ rcPos.x - 1, rcPos.y + 1 });
-    Cell &bC = getCellAtBlockPosition({ rcPos.x, rcPos.y + 1 });
-    Cell &bR = getCellAtBlockPosition({ rcPos.x + 1, rcPos.y + 1 });
-    
-    if (tL.adjacentMines >= 0 && tL.state != CellState_Open) uncoverPartOfBoard(tL);
-    if (tC.adjacentMines >= 0 && tC.state != CellState_Open) uncoverPartOfBoard(tC);
-    if (tR.adjacentMines >= 0 && tR.state != CellState_Open) uncoverPartOfBoard(tR);
-    if (cL.adjacentMines >= 0 && cL.state != CellState_Open) uncoverPartOfBoard(cL);
-    if (cR.adjacentMines >= 0 && cR.state != CellState_Open) uncoverPartOfBoard(cR);
-    if (bL.adjacentMines >= 0 && bL.state != CellState_Open) uncoverPartOfBoard(bL);
-    if (bC.adjacentMines >= 0 && bC.state != CellState_Open) uncoverPartOfBoard(bC);
-    if (bR.adjacentMines >= 0 && bR.state != CellState_Open) uncoverPartOfBoard(bR);
-}
-
-static void assignCellsAdjacentMineCounts()
-{
-    for (int cellIndex = 0;
-         cellIndex < gameCells.size();
-         cellIndex++)
-    {
-        Cell &currentCell = gameCells[cellIndex];
-        if (currentCell.assignedAdjMines) continue;
+    if (gGameDelta.status != GameStatus_Playing)
+    {
+        finishGameRecording();
         
-        assignAdjacentMineCounts(currentCell);
+        if (gReplaying && gGameDelta.status != gReplayRecord.header.status)
+        {
+            std::cout << "Replay diverged from the recording" << std::endl;
+        }
     }
 }
 
-static Cell &getCellAtBlockPosition(Vector2i position)
+// Highlights a cell the solver can prove is safe.  The solver only looks
+// at what the player can see, so this never gives away anything else.
+static void showHint()
 {
-    if (position.x < 0 || position.x >= gDifficulty.nCols ||
-        position.y < 0 || position.y >= gDifficulty.nRows)
-    {
-        return defaultCell;
-    }
+    solve(gSolver, gGame.board);
     
-    int cellIndex = get1dIndexFor2dIndex(position, {
-        gDifficulty.nCols,
-        gDifficulty.nRows
-    });
+    // -1 when there's no safe cell, which just clears the old hint.
+    int hintCellIndex = getNextSafeCell(gSolver, gGame.board);
     
-    return gameCells[cellIndex];
+    markCellDirty(gHintCellIndex);
+    markCellDirty(hintCellIndex);
+    gHintCellIndex = hintCellIndex;
 }
 
-static void winGame()
+// How long this takes shows in the F4 profile.
+static void updateProbabilities()
 {
-    gState = GameState_Win;
-    revealMines();
+    PROFILE_SCOPE("updateProbabilities");
+    
+    solve(gSolver, gGame.board);
+    computeMineProbabilities(gProbabilityMap, gSolver, gGame.board, gGame.nMines, &gWorkPool);
+}
+
+static void benchmarkRenderPaths()
+{
+    const int nWarmupFrames = 10;
+    const int nFrames = 200;
+    
+    Difficulty presets[] = {
+        DIFFICULTY_EASY,
+        DIFFICULTY_MEDIUM,
+        DIFFICULTY_HARD,
+        gCustomDifficulty
+    };
+    const char *presetNames[] = { "Easy", "Medium", "Hard", "Custom" };
+    
+    // Vsync would hide the difference between the two paths.
+    SDL_SetHint(SDL_HINT_RENDER_VSYNC, "0");
+    initWindow();
+    
+    for (int presetIndex = 0; presetIndex < 4; presetIndex++)
+    {
+        gState = GameState_Game;
+        gDifficulty = presets[presetIndex];
+        initGame();
+        
+        // The mines only go down on the first reveal.
+        Command firstReveal = { CommandType_Reveal, gGame.board.nCells / 2 };
+        applyCommand(gGame, firstReveal, gGameDelta);
+        
+        // Open about half the board and flag some of the rest so every
+        // kind of cell shows up in the frame.
+        for (int cellIndex = 0;
+             cellIndex < gGame.board.nCells;
+             cellIndex++)
+        {
+            if (cellIndex % 2 == 0 && !cellHasMine(gGame.board, cellIndex))
+            {
+                setBit(gGame.board.open, cellIndex);
+            }
+            else if (cellIndex % 7 == 0)
+            {
+                setBit(gGame.board.flags, cellIndex);
+            }
+        }
+        
+        for (int batched = 0; batched < 2; batched++)
+        {
+            gBatchedRendering = batched == 1;
+            
+            Uint64 frequency = SDL_GetPerformanceFrequency();
+            Uint64 start = 0;
+            
+            for (int frame = 0; frame < nWarmupFrames + nFrames; frame++)
+            {
+                if (frame == nWarmupFrames)
+                {
+                    start = SDL_GetPerformanceCounter();
+                }
+                
+                // Full redraws, otherwise the dirty rects skip all the work.
+                markBoardDirty();
+                render();
+                SDL_RenderPresent(gCurrentRenderer);
+            }
+            
+            double totalMs = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+            
+            std::cout << presetNames[presetIndex] << " "
+                      << (gBatchedRendering ? "batched" : "per-cell") << ": "
+                      << totalMs / nFrames << " ms/frame" << std::endl;
+        }
+        
+        quitGame();
+    }
+    
+    gBatchedRendering = true;
 }
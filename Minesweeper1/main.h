@@ -1,4 +1,5 @@
 #include <functional>
+#include <vector>
 typedef struct
 {
     int x, y;
@@ -14,13 +15,6 @@ typedef enum
     GameState_Win
 } GameState;
 
-typedef struct
-{
-    int nRows;
-    int nCols;
-    int nMines;
-} Difficulty;
-
 typedef enum {
     MouseMode_ClearMode,
     MouseMode_FlagMode
@@ -41,25 +35,75 @@ typedef struct
     ButtonState state;
     // Could also use a function override but whatevs
     std::function<void()> pressedCallback;
+    // Optional, for getting ready before the press.
+    std::function<void()> hoveredCallback;
 } Button;
 
-typedef enum
+typedef struct
 {
-    CellState_Closed,
-    CellState_Open
-} CellState;
+    double updateMs;
+    double renderMs;
+    double presentMs;
+    int nUpdates;
+} FrameTimings;
 
+// Frames are added up over FRAME_STATS_WINDOW frames; the overlay shows
+// the last full window so the numbers hold still long enough to read.
 typedef struct
 {
-    CellState state = CellState_Closed;
-    Vector2i position;
-    // This is sooooooooo confusing.
-    bool hasMine = false;
-    bool hasFlag = false;
-    bool hadFlag = false;
-    bool assignedAdjMines = false;
-    int adjacentMines = 0;
-} Cell;
+    FrameTimings sum;
+    FrameTimings worst;
+    int nFrames;
+    Uint64 windowStart;
+    FrameTimings shownAverage;
+    FrameTimings shownWorst;
+    double shownFps;
+    double shownUpdatesPerSecond;
+} FrameStats;
+
+// How many colors the mine probability overlay is rounded to.
+static const int PROBABILITY_SHADES = 9;
+
+// Cells sorted by what gets drawn for them, so the whole board is a
+// handful of SDL_RenderFillRects calls.
+typedef struct
+{
+    std::vector<SDL_Rect> closedRects;
+    std::vector<SDL_Rect> openRects;
+    std::vector<SDL_Rect> flagRects;
+    std::vector<SDL_Rect> probabilityRects[PROBABILITY_SHADES];
+    std::vector<SDL_Rect> hintRects;
+    std::vector<SDL_Rect> hoverRects;
+    std::vector<int> textCells;
+} CellBatch;
+
+// Where cells go when they're drawn: cell (x, y) lands at
+// (x * cellWidth - originX, y * cellHeight - originY) on the current target.
+typedef struct
+{
+    int originX;
+    int originY;
+    int cellWidth;
+    int cellHeight;
+} CellTransform;
+
+typedef struct
+{
+    // nullptr until the chunk is first on screen, and after it's evicted.
+    SDL_Texture *texture;
+    size_t textureBytes;
+    bool needsFullRedraw;
+    Uint64 lastDrawnFrame;
+} BoardChunk;
+
+// Chunk columns and rows, inclusive.
+typedef struct
+{
+    int firstCol;
+    int lastCol;
+    int firstRow;
+    int lastRow;
+} ChunkRange;
 
 typedef enum
 {
@@ -68,28 +112,51 @@ typedef enum
     MouseButton_Center
 } MouseButton;
 
+static const int WINDOW_POSX = SDL_WINDOWPOS_UNDEFINED;
+static const int WINDOW_POSY = SDL_WINDOWPOS_UNDEFINED;
+static const Uint32 WINDOW_FLAGS = 0;
+static const Uint32 RENDERER_FLAGS = SDL_RENDERER_ACCELERATED |
+                                     SDL_RENDERER_PRESENTVSYNC |
+                                     SDL_RENDERER_TARGETTEXTURE;
+
 static const char *LAUNCHER_TITLE = "Minesweeper Launcher";
-static const int LAUNCHER_POSX = SDL_WINDOWPOS_UNDEFINED;
-static const int LAUNCHER_POSY = SDL_WINDOWPOS_UNDEFINED;
 static const int LAUNCHER_WIDTH = 300;
-static const int LAUNCHER_HEIGHT = 140;
-static const Uint32 LAUNCHER_FLAGS = 0;
-static const Uint32 LAUNCHER_RENDERER_FLAGS = SDL_RENDERER_ACCELERATED |
-                                              SDL_RENDERER_PRESENTVSYNC;
+static const int LAUNCHER_HEIGHT = 180;
 static const int LAUNCHER_BUTTON_WIDTH = 100;
 static const int LAUNCHER_BUTTON_HEIGHT = 30;
 
 static const char *GAME_TITLE = "Minesweeper";
-static const int GAME_POSX = SDL_WINDOWPOS_UNDEFINED;
-static const int GAME_POSY = SDL_WINDOWPOS_UNDEFINED;
-static const Uint32 GAME_FLAGS = 0;
-static const Uint32 GAME_RENDERER_FLAGS = SDL_RENDERER_ACCELERATED |
-                                          SDL_RENDERER_PRESENTVSYNC;
+static const char *SAVE_FILE_NAME = "game.sav";
+static const char *TRACE_FILE_NAME = "trace.json";
 static const int GAME_HEADER_OFFSET = 32;
+// The window is the board's size within these, when the display's usable
+// area can't be found the maximums are used.
+static const int GAME_MIN_WIDTH = 256;
+static const int GAME_MAX_WIDTH = 1024;
+static const int GAME_MAX_HEIGHT = 768;
+static const int GAME_WINDOW_MARGIN = 64;
+static const int MAX_CUSTOM_CELLS = 1 << 24;
+static const int CHUNK_CELLS = 32;
+static const size_t CHUNK_TEXTURE_BUDGET = 64 << 20;
+static const int VIEWPORT_PAN_STEP = 128;
 
 static const double MS_PER_UPDATE = 1000.0 / 60.0;
+// After a long stall the loop gives up on the backlog past this many
+// updates instead of running them all back to back.
+static const int MAX_UPDATES_PER_FRAME = 5;
+static const int FRAME_STATS_WINDOW = 60;
+static const int FRAME_STATS_LINE_HEIGHT = 16;
+static const int FRAME_STATS_LINES = 7;
+// Updates to run after an event before the loop may block again.
+static const int IDLE_GRACE_UPDATES = 2;
+static const int HEADER_CLOCK_WIDTH = 32;
+static const int HEADER_MINE_COUNTER_X = 4;
+// Updates run per update while a replay is fast-forwarding.
+static const int REPLAY_FAST_FORWARD_UPDATES = 8;
 static const int CELL_WIDTH = 16;
 static const int CELL_HEIGHT = 16;
+// Overlay on the cell the H key suggests.
+static const SDL_Color HINT_COLOR = { 0, 255, 0, 127 };
 
 static const int ADJ_MINE_BOMB = -1;
 static const int ADJ_MINE_1 = 1;
@@ -104,13 +171,45 @@ static const int ADJ_MINE_8 = 8;
 // Global
 static void init();
 static void quit();
+static void initWindow();
+static void quitWindow();
 static void update();
 static void render();
+static void handleEvent(const SDL_Event &event);
+
+// Idling
+static bool isIdle();
+static int getMsUntilClockTick(double lag);
+static void waitForEvent(double lag);
+static void skipUpdates(int nUpdates);
+static void logCpuUse();
+static void renderHeaderClock();
+static void renderHeaderMineCounter();
+
+// Frame timing
+static double getElapsedMs(Uint64 start, Uint64 end);
+static double getGameTimeMs();
+static void recordFrameTimings(FrameStats &stats, FrameTimings timings);
+static void renderFrameStats();
+
+// Profiler
+static void renderProfile();
+static void writeTrace();
+
+// Replay
+static bool loadReplay(const char *path, int gameIndex);
+static void sendDueReplayCommands();
+static void finishGameRecording();
+
+// Save
+static bool resumeSavedGame();
+static void saveCurrentGame();
 
 // Launcher/Game should implement some "State" interface that has yet to be made
 
 // Launcher
 static void initLauncher();
+static void initLauncherButtons();
 static void quitLauncher();
 static void updateLauncher();
 static void renderLauncher();
@@ -118,20 +217,46 @@ static void renderLauncher();
 // Game
 static void initGame();
 static void quitGame();
+static BoardOrder getBoardOrder(Difficulty difficulty);
+static void recordRestartTime(Uint64 presentEnd);
+static void fitWindowToBoard();
+static void startGameView();
 static void updateGame();
 static void renderGame();
 static void setDifficulty(Difficulty difficulty);
-static Cell &getCellAtPosition(Vector2i position);
-static void putMinesInNRandomCells(int nCells);
-static void loseGame();
-static void revealMines();
-static void assignAdjacentMineCounts(Cell &rootCell);
-static void assignCellsAdjacentMineCounts();
-static Cell &getCellAtBlockPosition(Vector2i position);
-static void winGame();
+static int getCellIndexAtPosition(Vector2i position);
+static void sendGameCommand(Command command);
+static void queueInputEvent(InputEventType type, InputButton button, int x, int y, Uint32 timestamp);
+static void handleInputEvent(const InputEvent &event);
+static void toggleFlag(int cellIndex);
+static void showHint();
+static void updateProbabilities();
 // I don't like that this is in game.  Maybe pass in a mouse?  Use mouseWithinBounds?
 static bool mouseIsTouchingCell();
-static void uncoverPartOfBoard(Cell &rootCell);
+static Vector2i getCellPosition(int cellIndex);
+static SDL_Rect getCellRect(int cellIndex);
+
+// Board chunks
+static void initBoardChunks();
+static void quitBoardChunks();
+static void updateHoveredCell();
+static void patchBoardChunks(ChunkRange range);
+static int skipDirtyCellsBefore(int chunkIndex, int dirtyIndex);
+static bool drawChunk(int chunkIndex, int firstDirty, int lastDirty);
+static void queueChunkCells(int chunkIndex);
+static bool createChunkTexture(int chunkIndex);
+static void evictChunkTextures(size_t neededBytes);
+static void destroyChunkTextures();
+static int getChunkIndexForCell(int cellIndex);
+static ChunkRange getVisibleChunks();
+static SDL_Rect getChunkScreenRect(int chunkIndex);
+static void setCellTransformForChunk(int chunkIndex);
+static void setCellTransformForScreen();
+static void clearDirtyCells();
+static void markCellDirty(int cellIndex);
+static void markBoardDirty();
+static void panBoard(int dx, int dy);
+static void zoomBoard(double factor, Vector2i position);
 
 // Button
 static void updateButton(Button &button);
@@ -140,9 +265,30 @@ static void renderButton(Button button);
 // Font
 static TTF_Font *loadFont(const char *path, int ptsize);
 static void renderText(const char *text, Vector2i position, SDL_Color color);
+static void renderTextLeft(const char *text, Vector2i position, SDL_Color color);
+static void logTextAtlasStats(const TextAtlas &atlas);
 
 // Cell
-static void renderCell(Cell cell);
+static void renderCell(int cellIndex);
+static void renderCellText(int cellIndex);
+static SDL_Rect getFlagRect(int cellIndex);
+static void renderCellHover(int cellIndex);
+static SDL_Color getHoverColor();
+static void renderCellHint(int cellIndex);
+static void renderCellProbability(int cellIndex);
+static int getProbabilityShade(int cellIndex);
+static SDL_Color getProbabilityColor(int shade);
+
+// Cell batching
+static void queueCell(int cellIndex);
+static void queueCellHover(int cellIndex);
+static void queueCellHint(int cellIndex);
+static void flushCells();
+static void addCellToBatch(CellBatch &batch, int cellIndex);
+static void renderRects(const std::vector<SDL_Rect> &rects, SDL_Color color);
+static void renderCellBatch(const CellBatch &batch);
+static void clearCellBatch(CellBatch &batch);
+static void benchmarkRenderPaths();
 
 // Mouse
 // I might change this signature depending on where it's being called
@@ -151,6 +297,5 @@ static bool mouseButtonDown(MouseButton mouseButton);
 
 // Utility
 static int get1dIndexFor2dIndex(Vector2i index2d, Vector2i arraySize);
-static int random(int min, int max);
 // This only kind of goes in Utility (Game?)
 static SDL_Color getColorForAdjacentMineCount(int adjMineCount);
@@ -0,0 +1,18 @@
+#!/bin/bash
+
+# Builds the game engine on its own as a static library, no SDL needed.
+
+. engine.sh
+
+mkdir -p ../obj
+OBJECTS=()
+
+for file in "${ENGINE_SOURCE[@]}"; do
+    object=../obj/${file%.cpp}.o
+    echo "Compiling $file"
+    g++ -std=c++11 -O2 -g -pthread -c ../$file -o $object || exit 1
+    OBJECTS+=($object)
+done
+
+rm -f $ENGINE_LIB
+ar rcs $ENGINE_LIB "${OBJECTS[@]}"
@@ -0,0 +1,13 @@
+#!/bin/bash
+
+# The command line tools only link against the engine.
+
+. engine.sh
+
+./build_engine.sh || exit 1
+
+for tool in ../tools/*.cpp; do
+    name=$(basename $tool .cpp)
+    echo "Building $name"
+    g++ -std=c++11 -O2 -pthread $tool $ENGINE_LIB -o ../$name || exit 1
+done
@@ -0,0 +1,5 @@
+#!/bin/bash
+
+# The SDL-free part of the game.  None of these may include SDL.
+ENGINE_SOURCE=(Board.cpp BoardPool.cpp Random.cpp Game.cpp WorkPool.cpp Solver.cpp Probability.cpp Generator.cpp Replay.cpp Save.cpp Profile.cpp)
+ENGINE_LIB=../libMinesweeperEngine.a
@@ -0,0 +1,119 @@
+//
+//  bench_adjacency.cpp
+//  Minesweeper1
+//
+//  Times computeAdjacentMineCounts against the old per-cell version that
+//  looked up all eight neighbours with bounds checks.
+//
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#include "../Board.h"
+
+// What assignCellsAdjacentMineCounts used to do, minus the Cell struct.
+static void legacyAdjacentMineCounts(Board &board)
+{
+    for (int y = 0; y < board.height; y++)
+    {
+        for (int x = 0; x < board.width; x++)
+        {
+            int count = 0;
+
+            for (int dy = -1; dy <= 1; dy++)
+            {
+                for (int dx = -1; dx <= 1; dx++)
+                {
+                    if ((dx != 0 || dy != 0) &&
+                        isInsideBoard(board, x + dx, y + dy) &&
+                        cellHasMine(board, getCellIndex(board, x + dx, y + dy)))
+                    {
+                        count++;
+                    }
+                }
+            }
+
+            board.adjacentMines[getCellIndex(board, x, y)] = count;
+        }
+    }
+}
+
+static double bestOf(int nRuns, Board &board, void (*compute)(Board &, AdjacencyKernel), AdjacencyKernel kernel)
+{
+    double best = 1e30;
+
+    for (int run = 0; run < nRuns; run++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        compute(board, kernel);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+
+    return best;
+}
+
+static void legacy(Board &board, AdjacencyKernel)
+{
+    legacyAdjacentMineCounts(board);
+}
+
+static void kernel(Board &board, AdjacencyKernel adjacencyKernel)
+{
+    computeAdjacentMineCounts(board, adjacencyKernel);
+}
+
+int main()
+{
+    int sizes[] = { 64, 1000, 4000, 10000 };
+    const char *kernelNames[] = { "best", "scalar", "sse2", "avx2" };
+
+    std::mt19937 gen(1234);
+
+    for (int sizeIndex = 0; sizeIndex < 4; sizeIndex++)
+    {
+        int size = sizes[sizeIndex];
+        int nRuns = size >= 4000 ? 3 : 10;
+
+        Board board;
+        initBoard(board, size, size);
+
+        // Same density as Hard, about 10%.
+        std::bernoulli_distribution hasMine(400.0 / (64 * 64));
+
+        for (int cellIndex = 0; cellIndex < board.nCells; cellIndex++)
+        {
+            if (hasMine(gen))
+            {
+                setBit(board.mines, cellIndex);
+            }
+        }
+
+        double legacyMs = bestOf(nRuns, board, legacy, AdjacencyKernel_Best);
+        std::vector<uint8_t> expected = board.adjacentMines;
+
+        std::cout << size << "x" << size << " legacy: " << legacyMs << " ms" << std::endl;
+
+        for (int kernelIndex = AdjacencyKernel_Best;
+             kernelIndex <= AdjacencyKernel_AVX2;
+             kernelIndex++)
+        {
+            std::fill(board.adjacentMines.begin(), board.adjacentMines.end(), 0xFF);
+            double ms = bestOf(nRuns, board, kernel, (AdjacencyKernel)kernelIndex);
+
+            std::cout << size << "x" << size << " " << kernelNames[kernelIndex] << ": "
+                      << ms << " ms (" << legacyMs / ms << "x)";
+
+            if (board.adjacentMines != expected)
+            {
+                std::cout << " MISMATCH";
+            }
+
+            std::cout << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+//
+//  bench_generate.cpp
+//  Minesweeper1
+//
+//  Generates no-guess boards for every preset and reports how long that
+//  takes and how many candidates it went through.
+//
+//  bench_generate [--boards N] [--threads N] [--seed N]
+//
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+
+#include "../Game.h"
+#include "../Generator.h"
+#include "../WorkPool.h"
+
+typedef struct
+{
+    const char *name;
+    Difficulty difficulty;
+} Preset;
+
+static double getPercentile(const std::vector<double> &sorted, double percentile)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+
+    int index = (int)(percentile / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+int main(int argc, const char *argv[])
+{
+    int nBoards = 200;
+    int nThreads = 0;
+    uint64_t baseSeed = 1;
+
+    for (int argIndex = 1; argIndex + 1 < argc; argIndex += 2)
+    {
+        std::string arg = argv[argIndex];
+
+        if (arg == "--boards")
+        {
+            nBoards = atoi(argv[argIndex + 1]);
+        }
+        else if (arg == "--threads")
+        {
+            nThreads = atoi(argv[argIndex + 1]);
+        }
+        else if (arg == "--seed")
+        {
+            baseSeed = strtoull(argv[argIndex + 1], nullptr, 10);
+        }
+        else
+        {
+            std::cout << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    Preset presets[] = {
+        { "Easy", DIFFICULTY_EASY },
+        { "Medium", DIFFICULTY_MEDIUM },
+        { "Hard", DIFFICULTY_HARD }
+    };
+
+    WorkPool pool;
+    startWorkPool(pool, nThreads);
+
+    std::cout << nBoards << " no-guess boards per preset on "
+              << getWorkPoolThreadCount(pool) << " threads" << std::endl;
+
+    for (int presetIndex = 0; presetIndex < 3; presetIndex++)
+    {
+        const Preset &preset = presets[presetIndex];
+        int startCellIndex = getNoGuessStartCell(preset.difficulty);
+
+        Board board;
+        std::vector<double> milliseconds;
+        long long nCandidates = 0;
+        int nFailed = 0;
+
+        for (int boardIndex = 0; boardIndex < nBoards; boardIndex++)
+        {
+            NoGuessStats stats;
+
+            if (!generateNoGuessBoard(board, preset.difficulty, startCellIndex,
+                                      baseSeed + boardIndex, &pool, &stats))
+            {
+                nFailed++;
+            }
+
+            milliseconds.push_back(stats.milliseconds);
+            nCandidates += stats.nCandidates;
+        }
+
+        std::sort(milliseconds.begin(), milliseconds.end());
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << preset.name << ": ms p50 " << getPercentile(milliseconds, 50)
+                  << " p90 " << getPercentile(milliseconds, 90)
+                  << " p99 " << getPercentile(milliseconds, 99)
+                  << " max " << getPercentile(milliseconds, 100)
+                  << ", " << (double)nCandidates / std::max(nBoards, 1) << " candidates per board, "
+                  << nFailed << " failed" << std::endl;
+    }
+
+    stopWorkPool(pool);
+
+    return 0;
+}
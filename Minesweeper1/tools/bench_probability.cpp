@@ -0,0 +1,131 @@
+//
+//  bench_probability.cpp
+//  Minesweeper1
+//
+//  Plays Hard games with the solver, asking computeMineProbabilities for
+//  the safest guess whenever the solver is stuck, and reports how long
+//  those calls take against the one frame budget.
+//
+//  bench_probability [--games N] [--threads N] [--mines N]
+//
+//  --mines makes the 64x64 board denser, which makes the frontier harder.
+//
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+
+#include "../Game.h"
+#include "../Solver.h"
+#include "../Probability.h"
+#include "../WorkPool.h"
+
+static const double FRAME_MS = 1000.0 / 60.0;
+
+static double getPercentile(const std::vector<double> &sorted, double percentile)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+
+    int index = (int)(percentile / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+int main(int argc, const char *argv[])
+{
+    int nGames = 200;
+    int nThreads = 0;
+    Difficulty difficulty = DIFFICULTY_HARD;
+
+    for (int argIndex = 1; argIndex + 1 < argc; argIndex += 2)
+    {
+        std::string arg = argv[argIndex];
+
+        if (arg == "--games")
+        {
+            nGames = atoi(argv[argIndex + 1]);
+        }
+        else if (arg == "--threads")
+        {
+            nThreads = atoi(argv[argIndex + 1]);
+        }
+        else if (arg == "--mines")
+        {
+            difficulty.nMines = atoi(argv[argIndex + 1]);
+        }
+        else
+        {
+            std::cout << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    WorkPool pool;
+    startWorkPool(pool, nThreads);
+
+    Game game;
+    GameDelta delta;
+    Solver solver;
+    ProbabilityMap map;
+    std::vector<double> callMs;
+    int nWon = 0;
+    int nEstimated = 0;
+
+    for (int gameIndex = 0; gameIndex < nGames; gameIndex++)
+    {
+        newGame(game, difficulty, gameIndex + 1);
+        initSolver(solver, game.board);
+
+        while (game.status == GameStatus_Playing)
+        {
+            solve(solver, game.board);
+
+            int cellIndex = getNextSafeCell(solver, game.board);
+
+            if (cellIndex < 0)
+            {
+                auto start = std::chrono::steady_clock::now();
+                computeMineProbabilities(map, solver, game.board, game.nMines, &pool);
+                std::chrono::duration<double, std::milli> elapsed =
+                    std::chrono::steady_clock::now() - start;
+
+                callMs.push_back(elapsed.count());
+                nEstimated += map.exact ? 0 : 1;
+                cellIndex = map.bestGuessCell;
+            }
+
+            Command command = { CommandType_Reveal, cellIndex };
+            applyCommand(game, command, delta);
+            updateSolver(solver, game.board, delta.changedCells);
+        }
+
+        nWon += game.status == GameStatus_Won ? 1 : 0;
+    }
+
+    int nPoolThreads = getWorkPoolThreadCount(pool);
+    stopWorkPool(pool);
+
+    std::sort(callMs.begin(), callMs.end());
+
+    int nOverBudget = (int)(callMs.end() - std::upper_bound(callMs.begin(), callMs.end(), FRAME_MS));
+
+    std::cout << std::fixed << std::setprecision(3)
+              << nGames << " games of 64x64/" << difficulty.nMines << " on "
+              << nPoolThreads << " threads, "
+              << std::setprecision(1) << 100.0 * nWon / std::max(nGames, 1) << "% won" << std::endl
+              << callMs.size() << " probability calls, " << nEstimated << " estimated, "
+              << nOverBudget << " over " << FRAME_MS << " ms" << std::endl
+              << std::setprecision(3)
+              << "ms p50 " << getPercentile(callMs, 50)
+              << " p90 " << getPercentile(callMs, 90)
+              << " p99 " << getPercentile(callMs, 99)
+              << " max " << getPercentile(callMs, 100) << std::endl;
+
+    return 0;
+}
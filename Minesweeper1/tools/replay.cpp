@@ -0,0 +1,150 @@
+//
+//  replay.cpp
+//  Minesweeper1
+//
+//  Reads a replay archive and reports what is in it: how many games, how
+//  they ended, how long they took and how many commands they needed.
+//
+//  replay PATH [--verify] [--threads N]
+//
+//  The scan only reads headers.  --verify also plays every game again on
+//  every core and checks it ends the way it was recorded.
+//
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <stdlib.h>
+
+#include "../Game.h"
+#include "../Replay.h"
+#include "../WorkPool.h"
+
+static const int RECORDS_PER_TASK = 256;
+
+int main(int argc, const char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "replay PATH [--verify] [--threads N]" << std::endl;
+        return 1;
+    }
+
+    const char *path = argv[1];
+    bool verify = false;
+    int nThreads = 0;
+
+    for (int argIndex = 2; argIndex < argc; argIndex++)
+    {
+        std::string arg = argv[argIndex];
+
+        if (arg == "--verify")
+        {
+            verify = true;
+        }
+        else if (arg == "--threads" && argIndex + 1 < argc)
+        {
+            nThreads = atoi(argv[++argIndex]);
+        }
+        else
+        {
+            std::cout << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    ReplayArchive archive;
+
+    if (!openReplayArchive(archive, path))
+    {
+        std::cout << "Unable to open " << path << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<ReplayRecord> records;
+    ReplayRecord record;
+    int nByStatus[3] = { 0, 0, 0 };
+    uint64_t nCommands = 0;
+    uint64_t nUpdates = 0;
+    int nMismatched = 0;
+
+    while (nextReplayRecord(archive, record))
+    {
+        nByStatus[record.header.status <= GameStatus_Won ? record.header.status : 0]++;
+        nCommands += record.header.nCommands;
+        nUpdates += record.header.duration;
+
+        if (verify)
+        {
+            records.push_back(record);
+        }
+    }
+
+    std::chrono::duration<double> scanTime = std::chrono::steady_clock::now() - start;
+    int nGames = nByStatus[0] + nByStatus[1] + nByStatus[2];
+
+    if (archive.offset != archive.size)
+    {
+        std::cout << "Stopped at a bad record " << archive.offset << " bytes in" << std::endl;
+    }
+
+    std::cout << std::fixed << std::setprecision(1)
+              << nGames << " games in " << archive.size << " bytes ("
+              << (double)archive.size / std::max(nGames, 1) << " per game), scanned at "
+              << nGames / std::max(scanTime.count(), 1e-9) << " games/s" << std::endl
+              << nByStatus[GameStatus_Won] << " won, " << nByStatus[GameStatus_Lost] << " lost, "
+              << nByStatus[GameStatus_Playing] << " unfinished, "
+              << (double)nCommands / std::max(nGames, 1) << " commands and "
+              << (double)nUpdates / std::max(nGames, 1) << " updates per game" << std::endl;
+
+    if (verify)
+    {
+        WorkPool pool;
+        startWorkPool(pool, nThreads);
+        int nThreadsUsed = getWorkPoolThreadCount(pool);
+
+        WorkGroup group;
+        initWorkGroup(group);
+        std::atomic<int> nMismatchedGames(0);
+
+        start = std::chrono::steady_clock::now();
+
+        for (int firstRecord = 0; firstRecord < records.size(); firstRecord += RECORDS_PER_TASK)
+        {
+            int lastRecord = std::min(firstRecord + RECORDS_PER_TASK, (int)records.size());
+
+            submitWork(pool, group, [&records, &nMismatchedGames, firstRecord, lastRecord]() {
+                Game game;
+                GameDelta delta;
+
+                for (int recordIndex = firstRecord; recordIndex < lastRecord; recordIndex++)
+                {
+                    if (replayGame(game, delta, records[recordIndex]) != records[recordIndex].header.status)
+                    {
+                        nMismatchedGames++;
+                    }
+                }
+            });
+        }
+
+        waitForWorkGroup(pool, group);
+        stopWorkPool(pool);
+
+        std::chrono::duration<double> replayTime = std::chrono::steady_clock::now() - start;
+        nMismatched = nMismatchedGames;
+
+        std::cout << "Replayed on " << nThreadsUsed << " threads at "
+                  << records.size() / std::max(replayTime.count(), 1e-9) << " games/s, "
+                  << nMismatched << " ended differently" << std::endl;
+    }
+
+    closeReplayArchive(archive);
+
+    return nMismatched == 0 ? 0 : 1;
+}
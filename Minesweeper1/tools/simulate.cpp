@@ -0,0 +1,384 @@
+//
+//  simulate.cpp
+//  Minesweeper1
+//
+//  Plays lots of games on every core and reports throughput, win rate and
+//  how long single games take.
+//
+//  simulate [--games N] [--threads N] [--seed N] [--strategy solver|probability|random]
+//           [--record PATH]
+//
+//  The solver strategy opens whatever the solver proves safe and only
+//  guesses when it is stuck; probability guesses the cell least likely to be
+//  a mine instead of a random one; random just guesses every move.
+//
+//  --record appends every game to a replay archive, one move per update,
+//  in game order whatever the thread count.
+//
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../Game.h"
+#include "../Solver.h"
+#include "../Probability.h"
+#include "../Replay.h"
+#include "../WorkPool.h"
+
+static const int GAMES_PER_TASK = 64;
+
+typedef struct
+{
+    const char *name;
+    Difficulty difficulty;
+} Preset;
+
+typedef enum
+{
+    Strategy_Solver,
+    Strategy_Probability,
+    Strategy_Random
+} Strategy;
+
+typedef struct
+{
+    bool won;
+    double microseconds;
+} GameResult;
+
+// Closed, unflagged and, when there is a solver, not a known mine.
+static bool canGuessCell(const Board &board, const Solver *solver, int cellIndex)
+{
+    return !cellIsOpen(board, cellIndex) && !cellHasFlag(board, cellIndex) &&
+           (solver == nullptr || !isKnownMine(*solver, cellIndex));
+}
+
+static int pickRandomClosedCell(const Board &board, const Solver *solver, Random &random)
+{
+    // Most of the board is closed for most of a game, so guessing is
+    // quick; the scan only happens near the end.
+    for (int attempt = 0; attempt < 32; attempt++)
+    {
+        int cellIndex = randomInt(random, board.nCells);
+
+        if (canGuessCell(board, solver, cellIndex))
+        {
+            return cellIndex;
+        }
+    }
+
+    int nClosed = 0;
+
+    for (int cellIndex = 0; cellIndex < board.nCells; cellIndex++)
+    {
+        if (canGuessCell(board, solver, cellIndex))
+        {
+            nClosed++;
+        }
+    }
+
+    int pick = randomInt(random, nClosed);
+
+    for (int cellIndex = 0; cellIndex < board.nCells; cellIndex++)
+    {
+        if (canGuessCell(board, solver, cellIndex) && pick-- == 0)
+        {
+            return cellIndex;
+        }
+    }
+
+    return -1;
+}
+
+static void recordMove(ReplayRecorder *recorder, uint32_t time, Command command)
+{
+    if (recorder != nullptr)
+    {
+        recordCommand(*recorder, time, command);
+    }
+}
+
+static void finishMoves(ReplayRecorder *recorder, GameStatus status)
+{
+    if (recorder != nullptr)
+    {
+        finishRecording(*recorder, status);
+    }
+}
+
+static void playGame(Game &game,
+                     GameDelta &delta,
+                     Solver &solver,
+                     ProbabilityMap &map,
+                     Strategy strategy,
+                     Difficulty difficulty,
+                     uint64_t seed,
+                     ReplayRecorder *recorder)
+{
+    newGame(game, difficulty, seed);
+
+    if (recorder != nullptr)
+    {
+        startRecording(*recorder, seed, difficulty, 0);
+    }
+
+    uint32_t time = 0;
+
+    Random random;
+    seedRandom(random, seed ^ 0x5bd1e995);
+
+    if (strategy == Strategy_Random)
+    {
+        while (game.status == GameStatus_Playing)
+        {
+            Command command = { CommandType_Reveal, pickRandomClosedCell(game.board, nullptr, random) };
+            recordMove(recorder, time++, command);
+            applyCommand(game, command, delta);
+        }
+
+        finishMoves(recorder, game.status);
+        return;
+    }
+
+    initSolver(solver, game.board);
+
+    while (game.status == GameStatus_Playing)
+    {
+        solve(solver, game.board);
+
+        int cellIndex = getNextSafeCell(solver, game.board);
+
+        if (cellIndex < 0 && strategy == Strategy_Probability)
+        {
+            // Games already run in parallel, no need to split the work further.
+            computeMineProbabilities(map, solver, game.board, game.nMines, nullptr);
+            cellIndex = map.bestGuessCell;
+        }
+
+        if (cellIndex < 0)
+        {
+            cellIndex = pickRandomClosedCell(game.board, &solver, random);
+        }
+
+        Command command = { CommandType_Reveal, cellIndex };
+        recordMove(recorder, time++, command);
+        applyCommand(game, command, delta);
+        updateSolver(solver, game.board, delta.changedCells);
+    }
+
+    finishMoves(recorder, game.status);
+}
+
+static const char *getStrategyName(Strategy strategy)
+{
+    switch (strategy)
+    {
+        case Strategy_Solver:
+            return "solver";
+
+        case Strategy_Probability:
+            return "probability";
+
+        default:
+            return "random";
+    }
+}
+
+static double getPercentile(const std::vector<double> &sorted, double percentile)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+
+    int index = (int)(percentile / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+static int printUsage()
+{
+    std::cout << "simulate [--games N] [--threads N] [--seed N] [--record PATH] "
+                 "[--strategy solver|probability|random]" << std::endl;
+    return 1;
+}
+
+int main(int argc, const char *argv[])
+{
+    int nGames = 10000;
+    int nThreads = 0;
+    uint64_t baseSeed = 1;
+    Strategy strategy = Strategy_Solver;
+    const char *recordPath = nullptr;
+
+    for (int argIndex = 1; argIndex < argc; argIndex += 2)
+    {
+        std::string arg = argv[argIndex];
+
+        // Every option takes a value.
+        if (argIndex + 1 == argc)
+        {
+            return printUsage();
+        }
+
+        if (arg == "--games")
+        {
+            nGames = atoi(argv[argIndex + 1]);
+        }
+        else if (arg == "--threads")
+        {
+            nThreads = atoi(argv[argIndex + 1]);
+        }
+        else if (arg == "--seed")
+        {
+            baseSeed = strtoull(argv[argIndex + 1], nullptr, 10);
+        }
+        else if (arg == "--record")
+        {
+            recordPath = argv[argIndex + 1];
+        }
+        else if (arg == "--strategy")
+        {
+            std::string name = argv[argIndex + 1];
+
+            if (name == "solver")
+            {
+                strategy = Strategy_Solver;
+            }
+            else if (name == "probability")
+            {
+                strategy = Strategy_Probability;
+            }
+            else if (name == "random")
+            {
+                strategy = Strategy_Random;
+            }
+            else
+            {
+                std::cout << "Unknown strategy " << name << std::endl;
+                return 1;
+            }
+        }
+        else
+        {
+            return printUsage();
+        }
+    }
+
+    Preset presets[] = {
+        { "Easy", DIFFICULTY_EASY },
+        { "Medium", DIFFICULTY_MEDIUM },
+        { "Hard", DIFFICULTY_HARD }
+    };
+
+    FILE *recordFile = nullptr;
+
+    if (recordPath != nullptr)
+    {
+        recordFile = fopen(recordPath, "ab");
+
+        if (recordFile == nullptr)
+        {
+            std::cout << "Unable to open " << recordPath << std::endl;
+            return 1;
+        }
+    }
+
+    WorkPool pool;
+    startWorkPool(pool, nThreads);
+
+    std::cout << nGames << " games per preset on "
+              << getWorkPoolThreadCount(pool) << " threads, "
+              << getStrategyName(strategy) << " strategy" << std::endl;
+
+    for (int presetIndex = 0; presetIndex < 3; presetIndex++)
+    {
+        const Preset &preset = presets[presetIndex];
+        std::vector<GameResult> results(nGames);
+        // One buffer of records per task, written out in order afterwards.
+        std::vector<std::vector<uint8_t>> records(recordFile != nullptr ?
+                                                  (nGames + GAMES_PER_TASK - 1) / GAMES_PER_TASK : 0);
+
+        WorkGroup group;
+        initWorkGroup(group);
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (int firstGame = 0; firstGame < nGames; firstGame += GAMES_PER_TASK)
+        {
+            int lastGame = std::min(firstGame + GAMES_PER_TASK, nGames);
+
+            submitWork(pool, group, [&results, &records, &preset, strategy, baseSeed, firstGame, lastGame]() {
+                Game game;
+                GameDelta delta;
+                Solver solver;
+                ProbabilityMap map;
+                ReplayRecorder recorder;
+                ReplayRecorder *recorderOrNull = records.empty() ? nullptr : &recorder;
+
+                for (int gameIndex = firstGame; gameIndex < lastGame; gameIndex++)
+                {
+                    auto gameStart = std::chrono::steady_clock::now();
+                    playGame(game, delta, solver, map, strategy, preset.difficulty, baseSeed + gameIndex,
+                             recorderOrNull);
+                    std::chrono::duration<double, std::micro> elapsed =
+                        std::chrono::steady_clock::now() - gameStart;
+
+                    if (recorderOrNull != nullptr)
+                    {
+                        writeRecording(recorder, records[firstGame / GAMES_PER_TASK]);
+                    }
+
+                    results[gameIndex].won = game.status == GameStatus_Won;
+                    results[gameIndex].microseconds = elapsed.count();
+                }
+            });
+        }
+
+        waitForWorkGroup(pool, group);
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        for (int taskIndex = 0; taskIndex < records.size(); taskIndex++)
+        {
+            fwrite(records[taskIndex].data(), 1, records[taskIndex].size(), recordFile);
+        }
+
+        int nWon = 0;
+        std::vector<double> latencies;
+        latencies.reserve(nGames);
+
+        for (int gameIndex = 0; gameIndex < nGames; gameIndex++)
+        {
+            nWon += results[gameIndex].won ? 1 : 0;
+            latencies.push_back(results[gameIndex].microseconds);
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << preset.name << " (" << preset.difficulty.nCols << "x"
+                  << preset.difficulty.nRows << "/" << preset.difficulty.nMines << "): "
+                  << nGames / elapsed.count() << " games/s, "
+                  << 100.0 * nWon / std::max(nGames, 1) << "% won, latency us"
+                  << " p50 " << getPercentile(latencies, 50)
+                  << " p90 " << getPercentile(latencies, 90)
+                  << " p99 " << getPercentile(latencies, 99)
+                  << " max " << getPercentile(latencies, 100) << std::endl;
+    }
+
+    stopWorkPool(pool);
+
+    if (recordFile != nullptr && fclose(recordFile) != 0)
+    {
+        std::cout << "Unable to write " << recordPath << std::endl;
+        return 1;
+    }
+
+    return 0;
+}